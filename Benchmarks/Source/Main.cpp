@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Voice render benchmark. Drives Synth with held notes and reports the cost
+    of one block against the polyphony limit and the number of voices that
+    sound, so changes to the voice pool can be checked on the machine at hand.
+
+    Usage: OutsetBench [sampleRate] [blockSize] [renderThreads]
+    Defaults are 48000, 256 and 1. Each figure is the best of several runs;
+    run it on an otherwise idle machine and compare runs from the same one.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/DSP/Synth.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr int numRuns = 9;
+    constexpr double secondsPerRun = 2.0;
+
+    // Microseconds per block with `sounding` notes held under a `polyphony` voice limit.
+    // Algorithm 5, 1x, cycle cache off, so every block renders every sounding voice in full.
+    double timeBlock(int polyphony, int sounding, double sampleRate, int blockSize, int renderThreads)
+    {
+        Synth synth;
+        synth.allocateResources(sampleRate, blockSize);
+        synth.setCycleCaching(false);
+        synth.setNumRenderThreads(renderThreads);
+        synth.setPolyphony(polyphony);
+        synth.reset();
+        for (int i = 0; i < 6; ++i)
+        {
+            synth.updateOsc(0.0f, 0.0f, 0.5f, float(i % 3 + 1), 1.5f, i);
+            synth.updateADSR(0.01f, 0.3f, 0.7f, 30.0f, i);
+        }
+        synth.updateAlgorithm(4);
+
+        std::vector<float> left(static_cast<size_t>(blockSize)), right(static_cast<size_t>(blockSize));
+        float* outputs[2] = { left.data(), right.data() };
+        // Distinct notes, so no note retriggers a voice that is already sounding
+        for (int note = 0; note < sounding; ++note)
+            synth.midiMessage(0x90, uint8_t(note), 100);
+        for (int i = 0; i < 20; ++i)    // past the attack
+            synth.render(outputs, blockSize);
+
+        const int blocksPerRun = juce::jmax(1, int(secondsPerRun * sampleRate / blockSize));
+        double best = 1.0e9;
+        for (int run = 0; run < numRuns; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < blocksPerRun; ++i)
+                synth.render(outputs, blockSize);
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best / blocksPerRun * 1.0e6;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const double sampleRate = argc > 1 ? juce::String(argv[1]).getDoubleValue() : 48000.0;
+    const int blockSize = argc > 2 ? juce::String(argv[2]).getIntValue() : 256;
+    const int renderThreads = argc > 3 ? juce::String(argv[3]).getIntValue() : 1;
+    if (sampleRate <= 0.0 || blockSize <= 0 || renderThreads <= 0)
+    {
+        std::fprintf(stderr, "usage: OutsetBench [sampleRate] [blockSize] [renderThreads]\n");
+        return 1;
+    }
+
+    std::printf("%.0f Hz, %d-sample blocks, %d render thread(s); us per block (us per sounding voice)\n",
+                sampleRate, blockSize, renderThreads);
+    for (int polyphony : { 8, 32, 64, 128 })
+    {
+        std::printf("polyphony %3d:", polyphony);
+        for (int sounding : { 0, 1, 8, 32, 64, 128 })
+        {
+            if (sounding > polyphony)
+                break;
+            const double us = timeBlock(polyphony, sounding, sampleRate, blockSize, renderThreads);
+            if (sounding == 0)
+                std::printf("  idle %.1f", us);
+            else
+                std::printf("  %d: %.1f (%.1f)", sounding, us, us / sounding);
+            std::fflush(stdout);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -10,7 +10,54 @@
 
 #pragma once
 #include <JuceHeader.h>
-#include "Operator.h"
+#include <array>
+
+/*
+AlgSchedule is a flat, precompiled evaluation plan for one algorithm.
+Operators are listed modulators-first, so a voice can run them linearly.
+All indices here are zero-based.
+*/
+struct AlgSchedule
+{
+	static constexpr int numOperators = 6;
+
+	std::array<uint8_t, numOperators> order{};                          // evaluation order, modulators first
+	std::array<uint8_t, numOperators> numMods{};                        // modulator count per operator
+	std::array<std::array<uint8_t, numOperators>, numOperators> modSources{}; // modulator indices per operator
+	std::array<uint8_t, numOperators> delayedMask{};                    // bit j set: modSources[op][j] reads the previous sample
+	uint8_t carrierMask = 0;                                            // bit i set: operator i is a carrier
+	float carrierGain = 1.f;                                            // 1 / number of carriers
+	int feedbackOperator = -1;                                          // -1 means no feedback operator
+	bool hasDelayEdges = false;                                         // true when the routing contains a loop between operators
+
+	constexpr bool isCarrier(int op) const { return (carrierMask >> op) & 1; }
+	constexpr bool isDelayed(int op, int modSlot) const { return (delayedMask[op] >> modSlot) & 1; }
+};
+
+/*
+MatrixAlgorithm is a user-defined routing: a depth for every modulator and
+modulated operator pair, the diagonal being self-feedback, and an output level
+per operator. Every edge reads its modulator's previous sample, so the routing
+has no evaluation order and any loop or cross-feedback is allowed; each sample
+the modulation of all six operators is one matrix-vector product. The rows are
+padded to `lanes` so that product runs in full SIMD registers.
+*/
+struct MatrixAlgorithm
+{
+	static constexpr int numOperators = AlgSchedule::numOperators;
+	static constexpr int lanes = 8;
+
+	alignas(32) std::array<std::array<float, lanes>, numOperators> depths{}; // depths[modulator][modulated]
+	alignas(32) std::array<float, lanes> outputLevels{};                    // zero: not a carrier
+	AlgSchedule schedule; // the same routing as a schedule, for the carrier checks and the bandwidth estimate
+	uint32_t revision = 0; // counts compile() calls, so voices caching this routing's output see edits
+
+	void setDepth(int modulated, int modulator, float depth) { depths[size_t(modulator)][size_t(modulated)] = depth; }
+	void setOutputLevel(int op, float level) { outputLevels[size_t(op)] = level; }
+	/// Rebuilds schedule after the depths or levels changed
+	void compile();
+};
+
 class AlgSpace
 {
 public:
@@ -18,29 +65,47 @@ public:
 	AlgSpace() = default;
 	~AlgSpace() = default;
 
-    /*
-	setAlgorithm will set modulation routing, assign carriers, and set feedback 
-	for all 32 algorithms
+	static constexpr int numAlgorithms = 32;
+
+	// All 32 algorithms, compiled at build time (defined below the class)
+	static const std::array<AlgSchedule, numAlgorithms> schedules;
+
+	/*
+	getSchedule returns the compiled routing, carriers and feedback for one
+	of the 32 algorithms
 	*/
-	void setAlgorithm(std::vector<Operator>& op, int algIndex) {
-		if (algIndex < 0 || algIndex >= algTable.size()) {
+	static const AlgSchedule& getSchedule(int algIndex) {
+		if (algIndex < 0 || algIndex >= numAlgorithms) {
 			jassertfalse;
-			return;
+			return schedules[0];
 		}
-		// clear routings
-		for (auto& opRef : op)
-			opRef.resetRouting();
+		return schedules[algIndex];
+	}
 
-		const auto& alg = algTable[algIndex];
-		// map is one-based indexing, hence - 1
-		for (const auto& routing : alg.routings) {
-			if (routing.modulated > 0 && routing.modulator > 0)
-				op[routing.modulated - 1].addModOperator(&op[routing.modulator - 1]);
+	/*
+	compileMatrix describes a matrix routing as a schedule. Every nonzero depth is an
+	edge, and every edge is a delay edge, like the matrix kernel evaluates them. The
+	output levels weight the carriers, so carrierGain stays 1.
+	*/
+	static AlgSchedule compileMatrix(const MatrixAlgorithm& matrix) {
+		AlgSchedule schedule;
+		for (int dst = 0; dst < AlgSchedule::numOperators; dst++) {
+			for (int src = 0; src < AlgSchedule::numOperators; src++) {
+				if (matrix.depths[size_t(src)][size_t(dst)] != 0.f) {
+					schedule.delayedMask[dst] |= uint8_t(1 << schedule.numMods[dst]);
+					schedule.modSources[dst][schedule.numMods[dst]++] = uint8_t(src);
+					schedule.hasDelayEdges = true;
+				}
+			}
+			if (matrix.outputLevels[size_t(dst)] != 0.f)
+				schedule.carrierMask |= uint8_t(1 << dst);
 		}
-		for (int c : alg.carriers)
-			op[c - 1].setCarrier(true);
-		if (alg.feedbackOperator != -1)
-			op[alg.feedbackOperator - 1].setFeedback(true);
+		// The order only matters to the bandwidth estimate, which walks modulators first
+		int numOrdered = 0;
+		std::array<uint8_t, AlgSchedule::numOperators> visitState{};
+		for (int i = 0; i < AlgSchedule::numOperators; i++)
+			visit(schedule, i, visitState, numOrdered);
+		return schedule;
 	}
 private:
 	struct algRouting {
@@ -48,11 +113,68 @@ private:
 		int modulator;
 	};
 	struct algDescription {
-		std::vector<algRouting> routings;
-		std::vector<int> carriers;
+		algRouting routings[6]; // unused entries are zero
+		int carriers[6];        // unused entries are zero
 		int feedbackOperator; // -1 means no feedback opereator
 	};
-	const std::vector<algDescription> algTable = {
+	/*
+	compile orders the operators with a depth-first walk from each operator to its
+	modulators. An edge that closes a loop (algorithms 4 and 6) becomes a delay edge:
+	the modulated operator reads its modulator's previous sample instead of recursing.
+	*/
+	static constexpr AlgSchedule compile(const algDescription& alg) {
+		AlgSchedule schedule;
+		// map is one-based indexing, hence - 1
+		for (const auto& routing : alg.routings) {
+			if (routing.modulated > 0 && routing.modulator > 0) {
+				const int dst = routing.modulated - 1;
+				schedule.modSources[dst][schedule.numMods[dst]++] = uint8_t(routing.modulator - 1);
+			}
+		}
+
+		int numCarriers = 0;
+		for (int c : alg.carriers) {
+			if (c > 0) {
+				schedule.carrierMask |= uint8_t(1 << (c - 1));
+				numCarriers++;
+			}
+		}
+		schedule.carrierGain = 1.f / float(numCarriers);
+		schedule.feedbackOperator = alg.feedbackOperator > 0 ? alg.feedbackOperator - 1 : -1;
+
+		int numOrdered = 0;
+		std::array<uint8_t, AlgSchedule::numOperators> visitState{}; // 0 = unvisited, 1 = in progress, 2 = done
+		for (int i = 0; i < AlgSchedule::numOperators; i++)
+			visit(schedule, i, visitState, numOrdered);
+		return schedule;
+	}
+	static constexpr void visit(AlgSchedule& schedule, int op, std::array<uint8_t, AlgSchedule::numOperators>& visitState, int& numOrdered) {
+		if (visitState[op] != 0)
+			return;
+		visitState[op] = 1;
+		for (int m = 0; m < schedule.numMods[op]; m++) {
+			const int src = schedule.modSources[op][m];
+			if (visitState[src] == 1) {
+				// src is still being resolved further up the walk, so this edge closes a loop
+				schedule.delayedMask[op] |= uint8_t(1 << m);
+				schedule.hasDelayEdges = true;
+			}
+			else {
+				visit(schedule, src, visitState, numOrdered);
+			}
+		}
+		visitState[op] = 2;
+		schedule.order[numOrdered++] = uint8_t(op);
+	}
+
+	static constexpr std::array<AlgSchedule, numAlgorithms> compileAll() {
+		std::array<AlgSchedule, numAlgorithms> compiled{};
+		for (int i = 0; i < numAlgorithms; i++)
+			compiled[i] = compile(algTable[i]);
+		return compiled;
+	}
+
+	static constexpr algDescription algTable[numAlgorithms] = {
 		/*
 		Format:
 		{ { {modulated, modulator}, ... }, // routings
@@ -253,4 +375,16 @@ private:
 			6
 		},
 	};
-};
\ No newline at end of file
+};
+
+inline constexpr std::array<AlgSchedule, AlgSpace::numAlgorithms> AlgSpace::schedules = AlgSpace::compileAll();
+
+inline void MatrixAlgorithm::compile()
+{
+	schedule = AlgSpace::compileMatrix(*this);
+	++revision;
+}
+
+// Sanity checks on the compiled table
+static_assert(AlgSpace::schedules[3].hasDelayEdges && AlgSpace::schedules[5].hasDelayEdges, "algorithms 4 and 6 contain loops");
+static_assert(AlgSpace::schedules[0].carrierMask == 0x05 && AlgSpace::schedules[31].carrierMask == 0x3F, "unexpected carriers");
@@ -22,12 +22,26 @@
 class Envelope
 {
 public:
+    enum class Curve
+    {
+        Linear,
+        Exponential // DX7-style: convex attack, exponential decay and release
+    };
+
     struct Parameters
     {
         float attack = 0.1f;   // seconds
         float decay = 0.1f;    // seconds
         float sustain = 1.0f;  // level (0.0 to 1.0)
         float release = 0.1f;  // seconds
+        Curve curve = Curve::Linear;
+
+        bool operator== (const Parameters& other) const noexcept
+        {
+            return attack == other.attack && decay == other.decay && sustain == other.sustain
+                && release == other.release && curve == other.curve;
+        }
+        bool operator!= (const Parameters& other) const noexcept { return !(*this == other); }
     };
 
     enum class State
@@ -46,20 +60,28 @@ public:
         jassert(newSampleRate > 0.0);
         sampleRate = newSampleRate;
         updateRates();
+        beginSegment();
     }
 
     void setParameters(const Parameters& newParams) noexcept
     {
+        if (newParams == parameters)
+            return;
         parameters = newParams;
         updateRates();
+        beginSegment();
+    }
+
+    const Parameters& getParameters() const noexcept
+    {
+        return parameters;
     }
 
     void noteOn() noexcept
     {
         if (parameters.attack > 0.0f)
         {
-            state = State::Attack;
-            level = (state == State::Attack) ? level : 0.0f; // Continue from current if retriggering
+            state = State::Attack; // Continue from current level if retriggering
         }
         else if (parameters.decay > 0.0f)
         {
@@ -71,6 +93,7 @@ public:
             state = State::Sustain;
             level = parameters.sustain;
         }
+        beginSegment();
     }
 
     void noteOff() noexcept
@@ -90,6 +113,7 @@ public:
                 state = State::Idle;
                 level = 0.0f;
             }
+            beginSegment();
         }
     }
 
@@ -98,50 +122,51 @@ public:
         level = 0.0f;
         state = State::Idle;
         releaseStartLevel = 0.0f;
+        beginSegment();
     }
 
     float getNextSample() noexcept
     {
-        switch (state)
-        {
-            case State::Idle:
-                level = 0.0f;
-                break;
-
-            case State::Attack:
-                level += attackRate;
-                if (level >= 1.0f)
-                {
-                    level = 1.0f;
-                    if (parameters.decay > 0.0f)
-                        state = State::Decay;
-                    else
-                        goToSustain();
-                }
-                break;
+        renderBlock(&level, 1);
+        return level;
+    }
 
-            case State::Decay:
-                level -= decayRate;
-                if (level <= parameters.sustain)
-                    goToSustain();
-                break;
+    /*
+    renderBlock writes the next numSamples envelope values to out.
+    Each run covers the rest of the current segment (or the block, if shorter) and
+    is a single multiply-add per sample: level = level * coef + offset. Linear
+    segments use coef = 1, exponential ones approach a target just past the
+    segment's end level. Segment transitions only happen between runs.
+    */
+    void renderBlock(float* out, int numSamples) noexcept
+    {
+        int i = 0;
+        while (i < numSamples)
+        {
+            if (state == State::Idle || state == State::Sustain)
+            {
+                level = (state == State::Idle) ? 0.0f : parameters.sustain;
+                std::fill(out + i, out + numSamples, level);
+                return;
+            }
 
-            case State::Sustain:
-                level = parameters.sustain;
-                break;
+            const int run = juce::jmin(numSamples - i, samplesLeft);
+            float y = level;
+            for (int k = 0; k < run; ++k)
+            {
+                y = y * coef + offset;
+                out[i + k] = y;
+            }
+            level = y;
+            i += run;
+            samplesLeft -= run;
 
-            case State::Release:
-                // Release from whatever level we started at
-                level -= releaseRate;
-                if (level <= 0.0f)
-                {
-                    level = 0.0f;
-                    state = State::Idle;
-                }
-                break;
+            if (samplesLeft <= 0)
+            {
+                endSegment();
+                out[i - 1] = level; // the last sample of a segment lands exactly on its end level
+            }
         }
-
-        return level;
     }
 
     bool isActive() const noexcept
@@ -160,6 +185,10 @@ public:
     }
 
 private:
+    // Target overshoot for exponential segments, as a fraction of full scale
+    static constexpr float attackTargetRatio = 0.3f;
+    static constexpr float decayReleaseTargetRatio = 0.001f;
+
     void updateRates() noexcept
     {
         if (sampleRate <= 0.0)
@@ -180,6 +209,7 @@ private:
         releaseBaseRate = (parameters.release > 0.0f)
             ? (1.0f / (parameters.release * static_cast<float>(sampleRate)))
             : 0.0f;
+        updateReleaseRate();
     }
 
     void goToSustain() noexcept
@@ -188,6 +218,103 @@ private:
         state = State::Sustain;
     }
 
+    // Snaps the level to the end of the finished segment and moves to the next one
+    void endSegment() noexcept
+    {
+        switch (state)
+        {
+            case State::Attack:
+                level = 1.0f;
+                if (parameters.decay > 0.0f)
+                    state = State::Decay;
+                else
+                    goToSustain();
+                break;
+
+            case State::Decay:
+                goToSustain();
+                break;
+
+            case State::Release:
+                level = 0.0f;
+                state = State::Idle;
+                break;
+
+            case State::Idle:
+            case State::Sustain:
+                break;
+        }
+        beginSegment();
+    }
+
+    // Per-segment constants for the recurrence level = level * coef + offset, and the
+    // number of samples until the segment's end level is reached from the current level
+    void beginSegment() noexcept
+    {
+        const bool exponential = parameters.curve == Curve::Exponential;
+        const float fs = static_cast<float>(sampleRate);
+        float endLevel = 0.0f;
+        float segmentSeconds = 0.0f;
+        float linearStep = 0.0f;
+        float ratio = decayReleaseTargetRatio;
+
+        switch (state)
+        {
+            case State::Attack:
+                endLevel = 1.0f;
+                segmentSeconds = parameters.attack;
+                linearStep = attackRate;
+                ratio = -attackTargetRatio; // target sits above 1
+                break;
+
+            case State::Decay:
+                endLevel = parameters.sustain;
+                segmentSeconds = parameters.decay;
+                linearStep = -decayRate;
+                break;
+
+            case State::Release:
+                endLevel = 0.0f;
+                segmentSeconds = parameters.release;
+                linearStep = -releaseRate;
+                break;
+
+            case State::Idle:
+            case State::Sustain:
+                samplesLeft = 0;
+                return;
+        }
+
+        const float distance = endLevel - level; // signed, towards the end level
+        if (segmentSeconds <= 0.0f || distance * (linearStep >= 0.0f ? 1.0f : -1.0f) <= 0.0f)
+        {
+            // Nothing left to travel: finish on the next sample
+            coef = 1.0f;
+            offset = 0.0f;
+            samplesLeft = 1;
+            return;
+        }
+
+        if (!exponential)
+        {
+            coef = 1.0f;
+            offset = linearStep;
+            samplesLeft = juce::jmax(1, static_cast<int>(std::ceil(distance / linearStep)));
+            return;
+        }
+
+        // Exponential approach to a target just past the end level. The time constant is set so a
+        // full-scale segment takes segmentSeconds, like the linear version.
+        const float absRatio = std::abs(ratio);
+        const float target = endLevel - ratio;
+        const float segmentSamples = juce::jmax(1.0f, segmentSeconds * fs);
+        coef = std::exp(-std::log((1.0f + absRatio) / absRatio) / segmentSamples);
+        offset = target * (1.0f - coef);
+        // target + (level - target) * coef^k reaches endLevel when coef^k = (endLevel - target) / (level - target)
+        const float k = std::log((endLevel - target) / (level - target)) / std::log(coef);
+        samplesLeft = juce::jmax(1, static_cast<int>(std::ceil(k)));
+    }
+
     // When entering release, calculate actual rate based on current level
     void updateReleaseRate() noexcept
     {
@@ -213,4 +340,9 @@ private:
     float releaseBaseRate = 0.0f;
     float releaseRate = 0.0f;
     float releaseStartLevel = 0.0f; // Level when noteOff was called
+
+    // Current segment
+    float coef = 1.0f;
+    float offset = 0.0f;
+    int samplesLeft = 0;
 };
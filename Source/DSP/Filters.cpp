@@ -9,25 +9,32 @@
 */
 #include "Filters.h"
 
-Filters::Filters()
+template <typename SampleType>
+Filters<SampleType>::Filters()
 {
     // Reset the filter state on construction.
     filter.reset();
 }
 
-Filters::~Filters() {}
+template <typename SampleType>
+Filters<SampleType>::~Filters() {}
 
-void Filters::prepare(const juce::dsp::ProcessSpec& spec)
+template <typename SampleType>
+void Filters<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
 {
     filter.prepare(spec);
+    cutoffSmoother.reset(spec.sampleRate, rampSeconds);
+    resonanceSmoother.reset(spec.sampleRate, rampSeconds);
 }
 
-void Filters::reset()
+template <typename SampleType>
+void Filters<SampleType>::reset()
 {
     filter.reset();
 }
 
-void Filters::setType(FilterType type)
+template <typename SampleType>
+void Filters<SampleType>::setType(FilterType type)
 {
     switch (type)
     {
@@ -46,24 +53,74 @@ void Filters::setType(FilterType type)
     }
 }
 
-void Filters::setCutoffFrequency(float frequencyHz)
+template <typename SampleType>
+void Filters<SampleType>::setCutoffFrequency(float frequencyHz)
 {
-    filter.setCutoffFrequency(frequencyHz);
+    cutoffSmoother.setTarget(frequencyHz);
+    if (!cutoffSmoother.isRamping())
+        filter.setCutoffFrequency(static_cast<SampleType>(frequencyHz));
 }
 
-void Filters::setResonance(float resonance)
+template <typename SampleType>
+void Filters<SampleType>::setResonance(float resonance)
 {
-    filter.setResonance(resonance);
+    resonanceSmoother.setTarget(resonance);
+    if (!resonanceSmoother.isRamping())
+        filter.setResonance(static_cast<SampleType>(resonance));
 }
 
-void Filters::processBlock(juce::AudioBuffer<float>& buffer)
+template <typename SampleType>
+void Filters<SampleType>::snapToTargets()
 {
-    juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
+    cutoffSmoother.setCurrentAndTarget(cutoffSmoother.getTarget());
+    resonanceSmoother.setCurrentAndTarget(resonanceSmoother.getTarget());
+    filter.setCutoffFrequency(static_cast<SampleType>(cutoffSmoother.getTarget()));
+    filter.setResonance(static_cast<SampleType>(resonanceSmoother.getTarget()));
+}
+
+template <typename SampleType>
+void Filters<SampleType>::processBlock(juce::dsp::AudioBlock<SampleType> block)
+{
+    if (cutoffSmoother.isRamping() || resonanceSmoother.isRamping())
+    {
+        processRamped(block);
+        return;
+    }
+    juce::dsp::ProcessContextReplacing<SampleType> context(block);
     filter.process(context);
 }
 
+template <typename SampleType>
+void Filters<SampleType>::processRamped(juce::dsp::AudioBlock<SampleType> block)
+{
+    const int numChannels = static_cast<int>(block.getNumChannels());
+    const int numSamples = static_cast<int>(block.getNumSamples());
+    for (int start = 0; start < numSamples; start += rampBlockSize)
+    {
+        const int length = juce::jmin(rampBlockSize, numSamples - start);
+        const float* cutoff = cutoffSmoother.process(cutoffRamp.data(), length);
+        const float* resonance = resonanceSmoother.process(resonanceRamp.data(), length);
+        for (int i = 0; i < length; ++i)
+        {
+            // Coefficients follow the ramps sample by sample
+            if (cutoff != nullptr)
+                filter.setCutoffFrequency(static_cast<SampleType>(cutoff[i]));
+            if (resonance != nullptr)
+                filter.setResonance(static_cast<SampleType>(resonance[i]));
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                SampleType* samples = block.getChannelPointer(size_t(channel)) + start;
+                samples[i] = filter.processSample(channel, samples[i]);
+            }
+        }
+    }
+    filter.snapToZero();
+}
+
 //float Filters::processSample(float sample)
 //{
 //    return filter.processSample(sample);
 //}
+
+template class Filters<float>;
+template class Filters<double>;
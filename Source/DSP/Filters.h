@@ -11,7 +11,10 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "Smoothing.h"
 
+// SampleType is float or double; the parameter ramps stay float either way
+template <typename SampleType>
 class Filters
 {
 public:
@@ -25,18 +28,29 @@ public:
     void prepare(const juce::dsp::ProcessSpec& spec);
     void reset();
 
-    // Set filter parameters
+    // Set filter parameters. Cutoff and resonance changes ramp over rampSeconds
     void setType(FilterType type);
     void setCutoffFrequency(float frequencyHz);
     void setResonance(float resonance);
+    // Ends any cutoff or resonance ramp on its target
+    void snapToTargets();
 
-    // Process an entire audio buffer (in-place)
-    void processBlock(juce::AudioBuffer<float>& buffer);
+    // Process an entire block (in-place). The synth core is mono, so this is usually one channel
+    void processBlock(juce::dsp::AudioBlock<SampleType> block);
 
     // Optionally process a single sample
     //float processSample(float sample);
 
 private:
+    static constexpr double rampSeconds = 0.02;
+    static constexpr int rampBlockSize = 64;
+
+    // Per-sample path, used only while cutoff or resonance is ramping
+    void processRamped(juce::dsp::AudioBlock<SampleType> block);
+
     // Using JUCE’s TPT state variable filter (recommended over the older version)
-    juce::dsp::StateVariableTPTFilter<float> filter;
+    juce::dsp::StateVariableTPTFilter<SampleType> filter;
+    BlockSmoother cutoffSmoother { BlockSmoother::Curve::Exponential };
+    BlockSmoother resonanceSmoother;
+    std::array<float, rampBlockSize> cutoffRamp, resonanceRamp;
 };
@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    Modulation.cpp
+
+  ==============================================================================
+*/
+
+#include "Modulation.h"
+
+ModMatrix::ModMatrix()
+{
+    compile();
+}
+
+void ModMatrix::setRoute(int slot, ModSource source, int target, float amount)
+{
+    jassert(slot >= 0 && slot < numSlots);
+    auto& s = slots[size_t(slot)];
+    const int clampedTarget = juce::jlimit(0, ModTarget::numTargets - 1, target);
+    if (s.source == source && s.target == clampedTarget && s.amount == amount)
+        return;
+    s = { source, clampedTarget, amount };
+    compile();
+}
+
+void ModMatrix::setLfo(int index, LfoShape shape, float rateHz)
+{
+    jassert(index >= 0 && index < numLfos);
+    lfos[size_t(index)] = { shape, juce::jmax(0.f, rateHz) };
+}
+
+void ModMatrix::compile()
+{
+    // Sum the amounts per source and target, then list the targets that are moved at all
+    std::array<std::array<float, ModTarget::numTargets>, numSources> depths {};
+    for (const auto& slot : slots)
+    {
+        // Noise routes to the cutoff are dropped, see the top of Modulation.h
+        if (slot.source != ModSource::None && !(slot.source == ModSource::Noise && slot.target == ModTarget::cutoff))
+            depths[sourceIndex(slot.source)][size_t(slot.target)] += slot.amount;
+    }
+    for (int source = 0; source < numSources; ++source)
+    {
+        auto& list = compiled[size_t(source)];
+        list.size = 0;
+        for (int target = 0; target < ModTarget::numTargets; ++target)
+        {
+            const float depth = depths[size_t(source)][size_t(target)];
+            if (depth != 0.f)
+                list.routes[size_t(list.size++)] = { target, depth };
+        }
+    }
+    // Every source swings between -1 and 1, so the peak is at the summed magnitude of the depths
+    for (int target = 0; target < ModTarget::numTargets; ++target)
+    {
+        float depth = 0.f;
+        for (const auto& sourceDepths : depths)
+            depth += std::abs(sourceDepths[size_t(target)]);
+        peaks[size_t(target)] = ModTarget::controlValue(target, depth);
+    }
+}
+
+void ControlRateModulator::reset()
+{
+    for (int target = 0; target < ModTarget::numTargets; ++target)
+        values[size_t(target)] = ModTarget::restValue(target);
+    steps.fill(0.f);
+    lfo.restart();
+    samplesToControlPoint = 0;
+    snapNextPoint = true;
+}
+
+void ControlRateModulator::retrigger()
+{
+    lfo.restart();
+    samplesToControlPoint = 0;
+}
+
+void ControlRateModulator::setSampleRate(float sampleRate, int oversampling)
+{
+    secondsPerSample = 1.f / sampleRate;
+    // Same position between control points, in the new rate's samples
+    if (oversampling != oversamplingFactor)
+    {
+        samplesToControlPoint = samplesToControlPoint * oversampling / oversamplingFactor;
+        oversamplingFactor = oversampling;
+    }
+}
+
+int ControlRateModulator::process(const ModMatrix::RouteList& routes, const LfoSettings& settings, int controlInterval,
+                                  int numSamples, float* output, int stride)
+{
+    jassert(numSamples <= stride);
+    const int interval = controlInterval * oversamplingFactor;
+    int numPoints = 0;
+    for (int done = 0; done < numSamples;)
+    {
+        if (samplesToControlPoint <= 0)
+        {
+            // Control point: where the LFO will be one interval from now, and the ramp there
+            const float value = lfo.advance(settings, static_cast<float>(interval) * secondsPerSample);
+            const float stepScale = snapNextPoint ? 0.f : 1.f / static_cast<float>(interval);
+            steps.fill(0.f); // a target whose route was just added starts level, not on a stale ramp
+            for (const auto& route : routes)
+            {
+                const float target = ModTarget::controlValue(route.target, route.depth * value);
+                auto& current = values[size_t(route.target)];
+                if (snapNextPoint)
+                    current = target;
+                steps[size_t(route.target)] = (target - current) * stepScale;
+            }
+            snapNextPoint = false;
+            samplesToControlPoint = interval;
+            ++numPoints;
+        }
+        const int run = juce::jmin(samplesToControlPoint, numSamples - done);
+        float* routeOutput = output + done;
+        for (const auto& route : routes)
+        {
+            float value = values[size_t(route.target)];
+            const float step = steps[size_t(route.target)];
+            for (int t = 0; t < run; ++t)
+            {
+                value += step;
+                routeOutput[t] = value;
+            }
+            values[size_t(route.target)] = value;
+            routeOutput += stride;
+        }
+        samplesToControlPoint -= run;
+        done += run;
+    }
+    return numPoints;
+}
@@ -0,0 +1,320 @@
+/*
+  ==============================================================================
+
+    Modulation.h
+
+    LFOs and the modulation matrix. Two LFOs drive the routes: LFO 1 is global,
+    one free-running oscillator shared by every voice; LFO 2 runs per voice and
+    restarts with each note. A route adds an LFO, scaled by its amount, to an
+    operator's level, ratio or modulation index, or to the filter cutoff.
+    Noise is a third, per-voice source: the voice's white noise at the audio
+    rate, for breath and other irregular movement. It does not move the
+    cutoff: the voice filter takes its cutoff once per run, which would only
+    sample the noise.
+
+    Routes are evaluated at a control rate, every few samples, and the values
+    are interpolated linearly into the per-sample ramps the block renderers
+    already read (see OperatorRamps). The LFOs and the route sums run once per
+    control point; only the interpolation into the ramps runs per sample. Routes
+    of LFO 1 are applied once for all voices; only LFO 2 routes cost per voice.
+    The time the routes take is measured as they run and reported per source,
+    per route and control point (see ModulationLoad).
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+enum class LfoShape
+{
+    Sine, Triangle, Saw, Square, SampleAndHold  // order of the LFO shape choices
+};
+
+/// What drives a route
+enum class ModSource
+{
+    None, GlobalLfo, VoiceLfo, Noise  // order of the route source choices: "Off", "LFO 1", "LFO 2", "Noise"
+};
+
+/*
+Route targets: three per operator, then the filter cutoff. Level and ratio
+are scaled, the modulation index is offset, and the cutoff moves in octaves.
+*/
+namespace ModTarget
+{
+    enum OperatorParam { level, ratio, modIndex, numOperatorParams };
+    constexpr int numOperators = 6;
+    constexpr int cutoff = numOperators * numOperatorParams;
+    constexpr int numTargets = cutoff + 1;
+
+    constexpr int forOperator(int op, OperatorParam param) { return op * numOperatorParams + param; }
+
+    // Full-scale (modulation 1) depth of each kind of target
+    constexpr float maxRatioSemitones = 12.f;
+    constexpr float maxIndexOffset = 10.f;
+    constexpr float maxCutoffOctaves = 5.f;
+
+    /// Converts the summed modulation of a target to the value its ramps apply: a level or ratio
+    /// multiplier, an index offset or a cutoff offset in octaves
+    inline float controlValue(int target, float modulation)
+    {
+        if (target == cutoff)
+            return modulation * maxCutoffOctaves;
+        switch (target % numOperatorParams)
+        {
+            case level:    return juce::jmax(0.f, 1.f + modulation);
+            case ratio:    return std::exp2(modulation * maxRatioSemitones / 12.f);
+            default:       return modulation * maxIndexOffset;
+        }
+    }
+
+    /// controlValue with no modulation
+    inline float restValue(int target) { return controlValue(target, 0.f); }
+
+    /// controlValue of every sample of an audio-rate source, in place
+    inline void controlValues(int target, float* modulation, int numSamples)
+    {
+        if (target == cutoff)
+        {
+            juce::FloatVectorOperations::multiply(modulation, maxCutoffOctaves, numSamples);
+            return;
+        }
+        switch (target % numOperatorParams)
+        {
+            case level:
+                for (int t = 0; t < numSamples; ++t)
+                    modulation[t] = juce::jmax(0.f, 1.f + modulation[t]);
+                break;
+            case ratio:
+                for (int t = 0; t < numSamples; ++t)
+                    modulation[t] = std::exp2(modulation[t] * maxRatioSemitones / 12.f);
+                break;
+            default:
+                juce::FloatVectorOperations::multiply(modulation, maxIndexOffset, numSamples);
+                break;
+        }
+    }
+
+    /*
+    applyToRamp combines the control values of an operator target with the parameter
+    they modulate, in place: modulation becomes the parameter's ramp and is returned.
+    ramp is the parameter's own ramp, or null when it is static at value.
+    */
+    inline const float* applyToRamp(int target, float* modulation, const float* ramp, float value, int numSamples)
+    {
+        if (target % numOperatorParams == modIndex)
+        {
+            for (int t = 0; t < numSamples; ++t)
+                modulation[t] = juce::jmax(0.f, modulation[t] + (ramp != nullptr ? ramp[t] : value));
+        }
+        else if (ramp != nullptr)
+        {
+            for (int t = 0; t < numSamples; ++t)
+                modulation[t] *= ramp[t];
+        }
+        else
+        {
+            juce::FloatVectorOperations::multiply(modulation, value, numSamples);
+        }
+        return modulation;
+    }
+}
+
+struct LfoSettings
+{
+    LfoShape shape = LfoShape::Sine;
+    float rateHz = 1.f;
+};
+
+/* Phase of one LFO. Trivially copyable, so it moves with a copied voice. */
+struct LfoState
+{
+    float phase = 0.f;      // [0, 1)
+    float held = 0.f;       // sample-and-hold value
+    uint32_t random = 1u;   // generator state for sample-and-hold
+
+    /// Back to phase 0, with a new sample-and-hold value
+    void restart()
+    {
+        phase = 0.f;
+        nextHeldValue();
+    }
+
+    /// Advances by seconds and returns the value there, in [-1, 1]
+    float advance(const LfoSettings& settings, float seconds)
+    {
+        phase += settings.rateHz * seconds;
+        if (phase >= 1.f)
+        {
+            phase -= std::floor(phase);
+            nextHeldValue();
+        }
+        switch (settings.shape)
+        {
+            case LfoShape::Sine:          return std::sin(juce::MathConstants<float>::twoPi * phase);
+            case LfoShape::Triangle:      return phase < 0.25f ? 4.f * phase
+                                               : (phase < 0.75f ? 2.f - 4.f * phase : 4.f * phase - 4.f);
+            case LfoShape::Saw:           return 2.f * phase - 1.f;
+            case LfoShape::Square:        return phase < 0.5f ? 1.f : -1.f;
+            case LfoShape::SampleAndHold: return held;
+        }
+        return 0.f;
+    }
+
+    void nextHeldValue()
+    {
+        random = random * 1664525u + 1013904223u;
+        held = static_cast<float>(random >> 8) * (2.f / 16777216.f) - 1.f;
+    }
+};
+
+/*
+ModMatrix holds the routing: the route slots, the two LFOs' settings and the
+control interval. The slots are compiled into one list of active targets per
+source, with the amounts of slots sharing a target summed, so evaluation visits
+each routed target once per source and skips empty slots.
+*/
+class ModMatrix
+{
+public:
+    static constexpr int numSlots = 8;
+    static constexpr int numLfos = 2;
+    static constexpr int numSources = 3; // the two LFOs and noise
+
+    struct Route
+    {
+        int target = 0;
+        float depth = 0.f;
+    };
+
+    struct RouteList
+    {
+        std::array<Route, ModTarget::numTargets> routes;
+        int size = 0;
+
+        bool isEmpty() const { return size == 0; }
+        const Route* begin() const { return routes.data(); }
+        const Route* end() const { return routes.data() + size; }
+    };
+
+    ModMatrix();
+
+    void setRoute(int slot, ModSource source, int target, float amount);
+    void setLfo(int index, LfoShape shape, float rateHz);
+    /// Samples between control points, at the base rate. Oversampled voices use proportionally more.
+    void setControlInterval(int samples) { controlInterval = juce::jlimit(1, maxControlInterval, samples); }
+
+    const RouteList& getRoutes(ModSource source) const { return compiled[sourceIndex(source)]; }
+    const LfoSettings& getLfo(ModSource source) const { return lfos[size_t(source == ModSource::VoiceLfo)]; }
+    int getControlInterval() const { return controlInterval; }
+
+    /*
+    getPeakValue is the largest control value all sources together can give target,
+    e.g. the highest ratio multiplier. Voice::estimateBandwidth judges modulated
+    operators by it.
+    */
+    float getPeakValue(int target) const { return peaks[size_t(target)]; }
+
+    static constexpr int maxControlInterval = 256;
+    /// Index of a source in per-source arrays: LFO 1, LFO 2, noise
+    static size_t sourceIndex(ModSource source) { return source == ModSource::None ? 0 : size_t(source) - 1; }
+
+private:
+    void compile();
+
+    struct Slot
+    {
+        ModSource source = ModSource::None;
+        int target = 0;
+        float amount = 0.f;
+    };
+
+    std::array<Slot, numSlots> slots;
+    std::array<LfoSettings, numLfos> lfos;
+    std::array<RouteList, numSources> compiled;  // LFO 1, LFO 2, noise
+    std::array<float, ModTarget::numTargets> peaks;
+    int controlInterval = 32;
+};
+
+/*
+ModulationCost sums what routes cost per source: the control points evaluated,
+every sample for noise, and the high-resolution ticks spent computing them and
+folding them into the ramps. A voice fills its own while it renders; the voice
+handler gathers them once the block is done.
+*/
+struct ModulationCost
+{
+    std::array<juce::int64, ModMatrix::numSources> ticks {};
+    std::array<juce::int64, ModMatrix::numSources> points {};
+
+    /// Adds the work of one source that began at startTicks and evaluated numPoints control points
+    void add(ModSource source, juce::int64 startTicks, int numPoints)
+    {
+        const size_t s = ModMatrix::sourceIndex(source);
+        ticks[s] += juce::Time::getHighResolutionTicks() - startTicks;
+        points[s] += numPoints;
+    }
+
+    void add(const ModulationCost& other)
+    {
+        for (size_t s = 0; s < ticks.size(); ++s)
+        {
+            ticks[s] += other.ticks[s];
+            points[s] += other.points[s];
+        }
+    }
+
+    void clear()
+    {
+        ticks.fill(0);
+        points.fill(0);
+    }
+};
+
+/// What each source's routes cost since the last report, for a meter
+struct ModulationLoad
+{
+    std::array<int, ModMatrix::numSources> routes {};                   // active routes
+    std::array<double, ModMatrix::numSources> microsecondsPerPoint {};  // per route and control point, 0 when none ran
+};
+
+/*
+ControlRateModulator runs one LFO's routes: every interval samples it advances
+the LFO and computes each target's control value, then ramps linearly to it
+over the interval. The values lag the LFO by one control interval.
+*/
+class ControlRateModulator
+{
+public:
+    /// Back to rest: every target at its rest value. The next control point is taken at once, without a ramp.
+    void reset();
+    /// Restarts the LFO at phase 0, e.g. on a note-on; targets ramp from where they are
+    void retrigger();
+    void seed(uint32_t value) { lfo.random = value; }
+    /// oversampling is sampleRate as a multiple of the base rate; control points stay at the same times
+    void setSampleRate(float sampleRate, int oversampling);
+
+    /*
+    process writes numSamples values of every route in routes, route k from
+    output + k * stride on, so stride must be at least numSamples. Returns the
+    number of control points it took.
+    */
+    int process(const ModMatrix::RouteList& routes, const LfoSettings& settings, int controlInterval,
+                 int numSamples, float* output, int stride);
+
+    /// Current value of a target
+    float getValue(int target) const { return values[size_t(target)]; }
+
+private:
+    LfoState lfo;
+    std::array<float, ModTarget::numTargets> values {};
+    std::array<float, ModTarget::numTargets> steps {};
+    float secondsPerSample = 1.f / 48000.f;
+    int oversamplingFactor = 1;
+    int samplesToControlPoint = 0;
+    bool snapNextPoint = true;
+};
@@ -1,7 +1,7 @@
 /*
   ==============================================================================
 
-    Noise.h
+    NoiseGenerator.h
     Created: 9 Mar 2025 1:56:04pm
     Author:  Quincy Winkler
 
@@ -9,26 +9,83 @@
 */
 
 #pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
 
-//noise gen from the book
+/*
+White noise in [-1, 1), from the book's linear congruential generator run as
+eight interleaved streams: sample t comes from stream t % 8. Each step of the
+streams is the same multiply-add on eight 32-bit lanes, so process() fills a
+block in SIMD registers instead of one dependent multiply per sample.
+
+The streams start from seed() alone, so a voice seeded with its index renders
+the same noise every time, e.g. in an offline bounce.
+*/
 class NoiseGenerator
 {
 public:
-    void reset() 
+    static constexpr int lanes = 8;
+
+    NoiseGenerator() { seed(22222); }
+
+    /// Restarts every stream from value; different values give uncorrelated noise
+    void seed(uint32_t value)
     {
-        noiseSeed = 22222;
+        seedValue = value;
+        reset();
     }
-    float nextValue() 
+
+    /// Back to the start of the current seed's noise
+    void reset()
     {
-        // Generate the next integer pseudorandom number.
-        noiseSeed = noiseSeed * 196314165 + 907633515;
-        
-        // Convert to a signed value.
-        int temp = int(noiseSeed >> 7) - 16777216;
-        
-        // Convert to a floating-point number between -1.0 and 1.0.
-        return float(temp) / 16777216.0f;
+        // Scramble seed and lane so neighbouring seeds and lanes start far apart
+        for (uint32_t k = 0; k < uint32_t(lanes); ++k)
+        {
+            uint32_t x = seedValue * 0x9E3779B9u + (k + 1) * 0x85EBCA6Bu;
+            x ^= x >> 16;
+            x *= 0x7FEB352Du;
+            x ^= x >> 15;
+            state[k] = x;
+        }
+        position = 0;
     }
+
+    /// Writes the next numSamples values
+    void process(float* output, int numSamples)
+    {
+        int t = 0;
+        // Finish the streams' current step, so whole steps follow
+        for (; position != 0 && t < numSamples; ++t)
+            output[t] = nextValue();
+        for (; t + lanes <= numSamples; t += lanes)
+        {
+            for (int k = 0; k < lanes; ++k)
+            {
+                state[size_t(k)] = step(state[size_t(k)]);
+                output[t + k] = toFloat(state[size_t(k)]);
+            }
+        }
+        for (; t < numSamples; ++t)
+            output[t] = nextValue();
+    }
+
+    float nextValue()
+    {
+        auto& s = state[size_t(position)];
+        s = step(s);
+        position = (position + 1) % lanes;
+        return toFloat(s);
+    }
+
 private:
-    unsigned int noiseSeed;
+    // Generate the next integer pseudorandom number
+    static uint32_t step(uint32_t s) { return s * 196314165u + 907633515u; }
+
+    // The top 25 bits as a signed value, scaled to [-1.0, 1.0)
+    static float toFloat(uint32_t s) { return float(int32_t(s >> 7) - 16777216) * (1.0f / 16777216.0f); }
+
+    alignas(32) std::array<uint32_t, lanes> state {};
+    uint32_t seedValue = 22222;
+    int position = 0; // stream of the next sample
 };
@@ -9,6 +9,7 @@
 */
 
 #include "Operator.h"
+#include <numeric>
 
 Operator::Operator()
 {
@@ -17,15 +18,13 @@ Operator::Operator()
 	env.setParameters({ 0.1f, 0.1f, 0.8f, 0.1f });
 	// Initialise runtime variables to safe defaults
 	note = -1;
-	cached = false;
 	lastSample = 0.f;
-	cachedSample = 0.f;
-	ratio = 1.f;
+	pitchScale = 1.f;
 	level = 0.5f;
-	tuning = 0.f;
 	ampValue = 1.f;
 	envValue = 1.f;
 	baseFrequency = 261.63f; // Middle C reference
+	initLanes();
 }
 
 Operator::Operator(int index)
@@ -36,14 +35,14 @@ Operator::Operator(int index)
 	env.setParameters({ 0.1f, 0.1f, 0.8f, 0.1f });
 	level = 0.5f;
 	osc.amplitude = 0.5f;
-	ratio = 1.f;
+	pitchScale = 1.f;
 	baseFrequency = 261.63f;
-	tuning = 0;
 	note = -1; // not assigned yet
 	setFrequency(baseFrequency);
-	cached = false;
 	lastSample = 0.f;
-	cachedSample = 0.f;
+	ampValue = 0.f;
+	envValue = 0.f;
+	initLanes();
 }
 
 Operator::~Operator()
@@ -55,7 +54,6 @@ void Operator::init(int opIndex_) // deprecated
 	opIndex = opIndex_;
 	env.setSampleRate(48000);
 	env.setParameters({ 0.1f, 0.1f, 0.8f, 0.1f });
-	freqSmooth.reset(int(50));
 	ampSmooth.reset(int(50));
 }
 
@@ -63,21 +61,137 @@ void Operator::reset(float fs) {
 	sampleRate = fs;
 	env.setSampleRate(fs);
 	osc.reset();
-	freqSmooth.reset(int(50));
-	ampSmooth.reset(int(50));
-	// do not alter baseFrequency here; it depends on the current note/ratio/tuning
-	cached = false;
+	ampSmooth.reset(ampSmoothSteps);
+	feedbackSmoothing = 0.5f;
+	feedbackDelay = 1;
+	feedbackPos = 0;
+	// do not alter baseFrequency here; it depends on the current note and pitch scale
 
 }
-void Operator::resetCache() {
-	cached = false;
+void Operator::setSampleRate(float fs, float timbreScale)
+{
+	sampleRate = fs;
+	env.setSampleRate(fs);
+	setFrequency(baseFrequency);
+	// SmoothedValue::reset jumps to the target, so carry the current amplitude over
+	const float amp = ampSmooth.getCurrentValue();
+	ampSmooth.reset(juce::roundToInt(float(ampSmoothSteps) * timbreScale));
+	ampSmooth.setCurrentAndTargetValue(amp);
+	feedbackSmoothing = 1.f - std::pow(0.5f, 1.f / timbreScale);
+	jassert(timbreScale >= 1.f && timbreScale <= float(maxOversampling));
+	feedbackDelay = juce::jlimit(1, maxOversampling, juce::roundToInt(timbreScale));
+	feedbackPos = 0;
+	feedbackHistory.fill(lastSample);
+	for (auto& history : laneFeedbackHistory)
+		history = laneLastSample;
+}
+void Operator::resetFeedback() {
 	lastSample = 0.f; // important so feedback from a previous note doesn't affect the next
-	cachedSample = 0.f;
+	feedbackHistory.fill(0.f);
+	laneLastSample.fill(0.f);
+	for (auto& history : laneFeedbackHistory)
+		history.fill(0.f);
+}
+void Operator::initLanes()
+{
+	// Lanes start spread over the cycle (golden-ratio steps), so a unison attack does not sum in phase.
+	// Fixed, so renders are reproducible
+	for (int k = 0; k < maxUnison; ++k)
+		lanePhase[size_t(k)] = uint32_t(k) * 0x9E3779B9u;
+	laneDetune.fill(1.f);
+}
+void Operator::setLaneDetune(const float* multipliers)
+{
+	std::copy(multipliers, multipliers + maxUnison, laneDetune.begin());
+}
+void Operator::handOverLanes(bool toLanes, int numLanes)
+{
+	jassert(numLanes >= 1 && numLanes <= maxUnison);
+	if (toLanes)
+	{
+		const uint32_t offset = osc.getPhaseWord() - getMeanLanePhase(numLanes);
+		for (auto& phase : lanePhase)
+			phase += offset;
+		laneLastSample.fill(lastSample);
+		for (size_t i = 0; i < feedbackHistory.size(); ++i)
+			laneFeedbackHistory[i].fill(feedbackHistory[i]);
+		return;
+	}
+	osc.setPhaseWord(getMeanLanePhase(numLanes));
+	const auto average = [numLanes](const std::array<float, maxUnison>& lanes) {
+		return std::accumulate(lanes.begin(), lanes.begin() + numLanes, 0.f) / float(numLanes);
+	};
+	lastSample = average(laneLastSample);
+	for (size_t i = 0; i < feedbackHistory.size(); ++i)
+		feedbackHistory[i] = average(laneFeedbackHistory[i]);
+}
+uint32_t Operator::getMeanLanePhase(int numLanes) const
+{
+	double x = 0.0, y = 0.0;
+	for (size_t k = 0; k < size_t(numLanes); ++k)
+	{
+		const double angle = double(lanePhase[k]) / FastSine::cycleToPhase * juce::MathConstants<double>::twoPi;
+		x += std::cos(angle);
+		y += std::sin(angle);
+	}
+	// Lanes spread evenly around the cycle cancel out and have no mean: fall back to the first
+	if (x * x + y * y < 1e-6)
+		return lanePhase[0];
+	const double cycles = std::atan2(y, x) / juce::MathConstants<double>::twoPi;
+	return uint32_t(int64_t(std::floor(cycles * FastSine::cycleToPhase)));
+}
+void Operator::updateLaneIncrements()
+{
+	for (size_t k = 0; k < size_t(maxUnison); ++k)
+		laneIncrement[k] = FastSine::frequencyToIncrement(baseFrequency * laneDetune[k], sampleRate);
+}
+void Operator::copySettingsToLanes(OperatorLanes& lanes) const
+{
+	lanes.sampleRate = sampleRate;
+	lanes.feedbackDelay = feedbackDelay;
+	lanes.feedback = feedback;
+	lanes.feedbackPos = 0;
+}
+void Operator::copyToLane(OperatorLanes& lanes, int k, int numSamples) const
+{
+	jassert(waveform == Waveform::Sine && modulationType == ModulationType::PM);
+	jassert(lanes.feedbackDelay == feedbackDelay && lanes.feedback == feedback && lanes.feedbackPos == 0);
+	const size_t lane = size_t(k);
+	for (size_t t = 0; t < size_t(numSamples); ++t)
+		lanes.amp[t][lane] = ampBuffer[t];
+	lanes.phase[lane] = osc.getPhaseWord();
+	lanes.increment[lane] = osc.getIncrement();
+	lanes.modIndex[lane] = modulationIndex;
+	lanes.noteFrequency[lane] = noteFrequency;
+	lanes.lastSample[lane] = lastSample;
+	lanes.smoothing[lane] = feedbackSmoothing;
+	for (int j = 0; j < feedbackDelay; ++j)
+		lanes.feedbackHistory[size_t(j)][lane] = feedbackHistory[size_t((feedbackPos + j) % feedbackDelay)];
+}
+void Operator::copyFromLane(const OperatorLanes& lanes, int k, int numSamples)
+{
+	const size_t lane = size_t(k);
+	osc.setPhaseWord(lanes.phase[lane]);
+	if (lanes.pitchRamp != nullptr)
+		setFrequency(lanes.pitchRamp[numSamples - 1] * noteFrequency);
+	lastSample = lanes.lastSample[lane];
+	for (int j = 0; j < feedbackDelay; ++j)
+		feedbackHistory[size_t(j)] = lanes.feedbackHistory[size_t(j)][lane];
+	feedbackPos = lanes.feedbackPos;
+}
+void OperatorLanes::silenceLane(int k, int numSamples)
+{
+	const size_t lane = size_t(k);
+	for (size_t t = 0; t < size_t(numSamples); ++t)
+		amp[t][lane] = 0.f;
+	phase[lane] = increment[lane] = 0;
+	modIndex[lane] = noteFrequency[lane] = lastSample[lane] = 0.f;
+	smoothing[lane] = 0.5f;
+	for (auto& history : feedbackHistory)
+		history[lane] = 0.f;
 }
 void Operator::setFrequency(float freq_)
 {
-	//freqSmooth.setTargetValue(freq_);
-	//osc.setFrequency(freqSmooth.getNextValue(), sampleRate);
 	osc.setFrequency(freq_, sampleRate);
 }
 
@@ -87,7 +201,7 @@ void Operator::updateEnvParams(float attack, float decay, float sustain, float r
 	//DBG("decay: " << decay);
 	//DBG("sustain: " << sustain);
 	//DBG("Release: " << release);
-	Envelope::Parameters params;
+	Envelope::Parameters params = env.getParameters();
 	params.attack = attack;
 	params.decay = decay;
 	params.sustain = sustain;
@@ -95,120 +209,115 @@ void Operator::updateEnvParams(float attack, float decay, float sustain, float r
 	env.setParameters(params);
 }
 
+void Operator::setEnvelopeCurve(Envelope::Curve curve)
+{
+	Envelope::Parameters params = env.getParameters();
+	params.curve = curve;
+	env.setParameters(params);
+}
+
 void Operator::setLevel(float level_)
 {
 	//DBG("Level: " << level_);
 	level = level_;
 }
 
-void Operator::addModOperator(Operator* mod)
+bool Operator::isSilent() const
 {
-	modOperators.push_back(mod);
+	if (ampSmooth.isSmoothing() || ampValue != 0.f)
+		return false;
+	return !env.isActive() || osc.amplitude * level == 0.f;
 }
-
-void Operator::resetRouting()
+float Operator::getLevelCeiling() const
 {
-	modOperators.clear();
-	setFeedback(false);
-	setCarrier(false);
+	const float gain = osc.amplitude * level;
+	if (env.getState() == Envelope::State::Attack)
+		return gain;
+	// Past the attack the envelope only falls, but the amplitude smoothing may still be rising
+	return juce::jmax(ampValue, gain * envValue);
 }
-float Operator::getCachedSample()
+void Operator::prepareBlock(int numSamples, const OperatorRamps& ramps)
 {
-	if (cached)
-		return cachedSample;
-
-	// Re-entrancy guard: cycle detection. If we re-enter while computing, fall back to previous sample (feedback style)
-	if (inProgress)
-		return lastSample;
-
-	inProgress = true;
-
-	// --- Gather modulation sum ---
-	float modSample = 0.f;
-	if (feedback)
-		modSample += lastSample * 0.25f; // scaled feedback
-
-	for (auto* mod : modOperators)
+	jassert(numSamples <= maxBlockSize);
+	modIndexRamp = ramps.modIndex;
+	pitchRamp = ramps.pitch;
+	if (pitchRamp == nullptr)
 	{
-		if (mod != nullptr)
-			modSample += mod->getCachedSample();
+		setFrequency(baseFrequency); // increment is fixed for the block
+		updateLaneIncrements();
 	}
 
-	// --- Advance envelope & amplitude smoothing once per sample ---
-	envValue = env.getNextSample();
-	ampSmooth.setTargetValue(osc.amplitude * level * envValue);
-	ampValue = ampSmooth.getNextValue();
-
-	// --- Apply modulation based on mode ---
-	float output = 0.f;
+	env.renderBlock(ampBuffer.data(), numSamples);
+	envValue = ampBuffer[size_t(numSamples - 1)];
 
-	if (modulationType == ModulationType::FM)
-	{
-		// Frequency Modulation: modulate instantaneous frequency (Hz)
-		float deviation = modulationIndex * modSample * baseFrequency;
-		float currentFreq = baseFrequency + deviation;
-		if (currentFreq < 0.f) currentFreq = 0.f;
-		setFrequency(currentFreq);
-		output = osc.nextSample() * ampValue;
+	if (ramps.level != nullptr) {
+		for (int i = 0; i < numSamples; ++i) {
+			ampSmooth.setTargetValue(osc.amplitude * ramps.level[i] * ampBuffer[size_t(i)]);
+			ampBuffer[size_t(i)] = ampSmooth.getNextValue();
+		}
 	}
-	else // ModulationType::PM
-	{
-		// Phase Modulation (DX7-style): modulate phase angle directly
-		// Keep base frequency stable (only update on note/param changes)
-		setFrequency(baseFrequency);
-		// Scale modulator output to radians (modulationIndex controls depth)
-		float phaseOffsetRadians = modulationIndex * modSample;
-		output = osc.nextSample(phaseOffsetRadians) * ampValue;
+	else {
+		const float gain = osc.amplitude * level;
+		for (int i = 0; i < numSamples; ++i) {
+			ampSmooth.setTargetValue(gain * ampBuffer[size_t(i)]);
+			ampBuffer[size_t(i)] = ampSmooth.getNextValue();
+		}
 	}
-
-	cachedSample = output;
-	lastSample = 0.5f * (cachedSample + lastSample); // mild smoothing for feedback tone
-
-	cached = true;
-	inProgress = false;
-	return cachedSample;
+	ampValue = ampBuffer[size_t(numSamples - 1)];
 }
-float Operator::getNextSample()
+void Operator::skipSamples(int numSamples)
 {
-	// Delegate to caching path so external code using getNextSample() still works
-	return getCachedSample();
+	if (env.isActive()) {
+		for (int i = 0; i < numSamples; i += maxBlockSize) {
+			const int n = juce::jmin(maxBlockSize, numSamples - i);
+			env.renderBlock(ampBuffer.data(), n);
+			envValue = ampBuffer[size_t(n - 1)];
+		}
+	}
+	setFrequency(baseFrequency);
+	osc.advance(numSamples);
+	updateLaneIncrements();
+	for (size_t k = 0; k < size_t(maxUnison); ++k)
+		lanePhase[k] += laneIncrement[k] * uint32_t(numSamples);
+	resetFeedback(); // output is zero, so the smoothed feedback has decayed away
 }
-
-void Operator::updateRatio(float ratio_)
+void Operator::advancePhase(int numSamples)
 {
-	ratio = ratio_;
-	if (note >= 0) {
-		float freq = ratio * 440.0f * std::exp2(float(note - 69 + tuning) / 12.0f);
-		baseFrequency = freq;
-	}
+	setFrequency(baseFrequency);
+	osc.advance(numSamples);
+}
+void Operator::setPitchScale(float scale)
+{
+	pitchScale = scale;
+	if (note >= 0)
+		baseFrequency = pitchScale * noteFrequency;
 }
 
 void Operator::updateLevel(float level_)
 {
 	level = level_;
 }
-void Operator::updateTuning(float fine, float coarse)
-{
-	tuning = coarse + fine / 100.0f;
-	if (note >= 0) {
-		float freq = ratio * 440.0f * std::exp2(float(note - 69 + tuning) / 12.0f);
-		baseFrequency = freq;
-	}
-}
 
-void Operator::noteOn(int note_, int velocity)
+void Operator::noteOn(int note_, int velocity, float frequency)
 {
 	note = note_;
-	float freq = ratio * 440.0f * std::exp2(float(note - 69 + tuning) / 12.0f); // this is the midi to freq formula
-	baseFrequency = freq; // stable base
+	noteFrequency = frequency;
+	baseFrequency = pitchScale * noteFrequency; // stable base
 	setFrequency(baseFrequency); // ensure oscillator increment set immediately
 	osc.amplitude = (velocity / 127.0f) * 0.5f;
 	env.noteOn();
-	lastSample = 0.f; // clear feedback for consistent retrigger
-	cached = false; // force recache in modulators
+	resetFeedback(); // clear feedback for consistent retrigger
 
 }
 void Operator::noteOff()
 {
 	env.noteOff();
 }
+void Operator::stop()
+{
+	env.reset();
+	ampSmooth.setCurrentAndTargetValue(0.f);
+	ampValue = 0.f;
+	envValue = 0.f;
+	resetFeedback();
+}
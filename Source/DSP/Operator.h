@@ -13,39 +13,137 @@
 #include "Envelope.h"
 #include <JuceHeader.h>
 
+// Per-sample ramps of the operator parameters for one block, shared by every voice.
+// A null pointer means the parameter is static and the operator's scalar value applies.
+struct OperatorRamps
+{
+	const float* level = nullptr;
+	const float* modIndex = nullptr;
+	const float* pitch = nullptr; // pitch scale, see Operator::setPitchScale
+
+	OperatorRamps advancedBy(int numSamples) const
+	{
+		return { level ? level + numSamples : nullptr,
+				 modIndex ? modIndex + numSamples : nullptr,
+				 pitch ? pitch + numSamples : nullptr };
+	}
+};
+
 enum class ModulationType
 {
 	FM,  // Frequency modulation (modulate Hz)
 	PM   // Phase modulation (DX7-style, modulate phase angle)
 };
 
+enum class Waveform // order of the WAVE_n choices
+{
+	Sine,  // the oscillator
+	Noise  // the voice's white noise, see setNoiseBlock; the modulation input is ignored
+};
+
+struct OperatorLanes;
+
 class Operator
 {
 public:
+	// Envelopes and amplitudes are rendered ahead in runs of at most this many samples
+	static constexpr int maxBlockSize = 64;
+	// Self-feedback reads lastSample as it was one base-rate sample ago, whatever the oversampling,
+	// so the loop (and the tone) does not change with the rate. At the base rate that is the previous sample
+	static constexpr int maxOversampling = 4;
+	// Unison: up to this many detuned copies of the oscillator (lanes) share the envelope and parameters
+	static constexpr int maxUnison = 8;
+
 	Operator();
 	Operator(int index);
 	~Operator();
 	void init(int opIndex_);
 	void setFrequency(float freq);
-	void setBaseFrequency(float freq);
 
 	void setLevel(float amplitude);
-	void addModOperator(Operator* modulator);
-	void resetRouting();
-	// having multiple operators has to be handled carefully. We cannot call nextSample() multiple
-	float getNextSample();
-	void noteOn(int note, int velocity);
+	// Render the envelope and smoothed amplitude for the next numSamples (<= maxBlockSize) samples.
+	// The ramps must stay valid until the block has been processed
+	void prepareBlock(int numSamples, const OperatorRamps& ramps);
+	// Advance the oscillator by one sample, at sample index t of the prepared block.
+	// modulation is the summed output of this operator's modulators
+	template <SineMode Mode>
+	float processSample(float modulation, int t);
+	// Unison counterpart of processSample: advances the lanes by one sample, lane k modulated by
+	// modulation[k] and written to output[k]. Each lane keeps its own phase and feedback. Both arrays
+	// hold maxUnison values; lanes from numLanes on may be computed anyway and are to be ignored
+	template <SineMode Mode>
+	void processLanes(const float* modulation, float* output, int numLanes, int t);
+	// Pitch multiplier of each unison lane, maxUnison values
+	void setLaneDetune(const float* multipliers);
+	// For a voice going from one lane to numLanes (toLanes) or back. The phase of the lanes' summed sine
+	// carries on from the oscillator's, the lanes keeping their spread, or the oscillator from that phase.
+	// Feedback carries over the same way, through the lanes' average
+	void handOverLanes(bool toLanes, int numLanes);
+	void setWaveform(Waveform newWaveform) { waveform = newWaveform; }
+	Waveform getWaveform() const { return waveform; }
+	// Noise a Noise operator outputs for the prepared block, read at the same index t as the envelope.
+	// laneNoise holds maxUnison values per sample, a different noise for each unison lane, so the lanes
+	// add up like detuned oscillators; only processLanes reads it. Both must stay valid until the block
+	// has been processed
+	void setNoiseBlock(const float* noise, const float* laneNoise)
+	{
+		noiseBlock = noise;
+		laneNoiseBlock = laneNoise;
+	}
+	// Cross-voice lanes, see VoiceBank. copySettingsToLanes gives lanes what the voices of a bank share;
+	// copyToLane puts this operator's state for the prepared run of numSamples into lane k, and
+	// copyFromLane takes it back once the lanes have rendered the run. Sine and PM only
+	void copySettingsToLanes(OperatorLanes& lanes) const;
+	void copyToLane(OperatorLanes& lanes, int k, int numSamples) const;
+	void copyFromLane(const OperatorLanes& lanes, int k, int numSamples);
+	// Smoothed previous output of each lane, the unison counterpart of getLastSample
+	const float* getLastLaneSamples() const { return laneLastSample.data(); }
+	// Smoothed output from the feedback delay ago: what a feedback operator adds, scaled, to the
+	// modulation of its next sample. Read before processSample for that sample
+	float getFeedbackSample() const { return feedbackHistory[size_t(feedbackPos)]; }
+	// The same for each unison lane, maxUnison values, read before processLanes
+	const float* getLaneFeedbackSamples() const { return laneFeedbackHistory[size_t(feedbackPos)].data(); }
+	// True when the output is zero for the coming block: the envelope has finished or the
+	// output level is zero, and the amplitude smoothing has settled
+	bool isSilent() const;
+	// Advance envelope and phase without rendering, used instead of processSample while silent
+	void skipSamples(int numSamples);
+	// True while the amplitude can only hold: the envelope is in its sustain and the amplitude smoothing has settled
+	bool isSteady() const { return env.getState() == Envelope::State::Sustain && !ampSmooth.isSmoothing(); }
+	// Advance the phase at the base frequency only; envelope and feedback are left as they are
+	void advancePhase(int numSamples);
+	// frequency is the note's pitch from the tuning table, before the pitch scale
+	void noteOn(int note, int velocity, float frequency);
 	void noteOff();
+	// Silence immediately: envelope to idle, amplitude smoothing and feedback cleared
+	void stop();
 	void reset(float fs);
-	void resetCache();
+	// Change the rate without interrupting the note: the envelope keeps its stage and level.
+	// The amplitude smoothing, feedback smoothing and feedback delay last timbreScale samples
+	// for each sample they take at 1: fs as a multiple of the base rate keeps their base-rate
+	// time constants, so the operator sounds the same at any rate; 1 keeps them per sample
+	void setSampleRate(float fs, float timbreScale);
+	void resetFeedback();
 	void updateEnvParams(float attack, float decay, float sustain, float release);
-	void updateRatio(float ratio_);
+	void setEnvelopeCurve(Envelope::Curve curve);
+	// Frequency ratio to the note, tuning included: ratio * 2^(tuning / 12)
+	void setPitchScale(float scale);
+	float getPitchScale() const { return pitchScale; }
 	void updateLevel(float level_);
-	void updateTuning(float fine, float coarse);
-	float getCachedSample();
-	bool isCarrier() { return carrier; }
-	void setCarrier(bool isCarrier) { carrier = isCarrier; }
-	bool isFeedback() { return feedback; }
+	// The level parameter, before the envelope
+	float getLevel() const { return level; }
+	// Smoothed previous output, read by delay edges that close a loop between operators
+	float getLastSample() const { return lastSample; }
+	// Output amplitude at the end of the last prepared block
+	float getOutputLevel() const { return ampValue; }
+	// Highest output amplitude the next block can reach: full level while the envelope attacks
+	float getLevelCeiling() const;
+	// Frequency of the current note times the pitch scale, before modulation
+	float getBaseFrequency() const { return baseFrequency; }
+	// Frequency of the current note from the tuning table, before the pitch scale
+	float getNoteFrequency() const { return noteFrequency; }
+	float getSampleRate() const { return sampleRate; }
+	bool isFeedback() const { return feedback; }
 	void setFeedback(bool isFeedback) { feedback = isFeedback; }
 	void setModulationType(ModulationType type) { modulationType = type; }
 	ModulationType getModulationType() const { return modulationType; }
@@ -53,23 +151,227 @@ public:
 	float getModulationIndex() const { return modulationIndex; }
 	Oscillator osc;
 	Envelope env;
-	void setCached() { cached = true; }
 private:
 	bool feedback = false; // feedback operator assignment
-	bool carrier = false; // carrier operator assignment
-	bool cached; // has the next sample been processed yet?
-	bool inProgress = false; // re-entrancy guard to break cycles
 	ModulationType modulationType = ModulationType::PM; // Default to DX7-style phase modulation
+	Waveform waveform = Waveform::Sine;
+	const float* noiseBlock = nullptr;
+	const float* laneNoiseBlock = nullptr;
 	float modulationIndex = 1.0f; // Modulation depth (FM index or PM index)
 	float lastSample = 0.f;
-	float cachedSample = 0.f;
+	float feedbackSmoothing = 0.5f; // one-pole coefficient of lastSample
+	std::array<float, maxOversampling> feedbackHistory{};
+	int feedbackDelay = 1, feedbackPos = 0;
+	static constexpr int ampSmoothSteps = 50; // at the base rate
 	int opIndex;
-	float sampleRate, baseFrequency, level, ratio, tuning, envValue, ampValue;
+	float sampleRate, baseFrequency, level, pitchScale, envValue, ampValue;
+	float noteFrequency = 0.f; // frequency of the MIDI note, before the pitch scale
 	int note;
-	std::vector<Operator*> modOperators;
-	juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> freqSmooth; //multiplicative for frequency per juce docs
 	juce::SmoothedValue<float> ampSmooth;
+	const float* modIndexRamp = nullptr; // ramps of the prepared block, see OperatorRamps
+	const float* pitchRamp = nullptr;
+	std::array<float, maxBlockSize> ampBuffer; // envelope times level, smoothed, for the prepared block
+	// Unison lanes, structure-of-arrays so a kernel step runs across them in SIMD registers
+	alignas(32) std::array<uint32_t, maxUnison> lanePhase;
+	alignas(32) std::array<uint32_t, maxUnison> laneIncrement{}; // at the base frequency, for the prepared block
+	alignas(32) std::array<float, maxUnison> laneDetune;
+	alignas(32) std::array<float, maxUnison> laneLastSample{};
+	std::array<std::array<float, maxUnison>, maxOversampling> laneFeedbackHistory{};
+	void initLanes();
+	void updateLaneIncrements();
+	// Phase of the sum of the first numLanes lanes' sines, their circular mean
+	uint32_t getMeanLanePhase(int numLanes) const;
 };
+
+/*
+OperatorLanes is one operator of up to `width` voices side by side: its oscillator
+and feedback state for the prepared run as [voice] arrays, so VoiceBank can step
+the operator across those voices at once, in SIMD registers. The state is copied
+in from each voice's Operator before a run and back after it. A lane whose voice
+is missing, or in which the operator is silent, has zero amplitude and feedback,
+so it outputs zero like a skipped operator and needs no branch.
+*/
+struct OperatorLanes
+{
+	static constexpr int width = 8;
+	using Floats = std::array<float, width>;
+
+	alignas(32) std::array<Floats, Operator::maxBlockSize> amp; // envelope times level, per sample of the run
+	alignas(32) std::array<uint32_t, width> phase, increment;
+	alignas(32) Floats modIndex, noteFrequency, lastSample, smoothing;
+	alignas(32) std::array<Floats, Operator::maxOversampling> feedbackHistory; // rotated so the run starts at 0
+	// Shared by the lanes
+	const float* modIndexRamp = nullptr;
+	const float* pitchRamp = nullptr;
+	float sampleRate = 48000.f;
+	int feedbackDelay = 1, feedbackPos = 0;
+	bool feedback = false;
+
+	// Lane k outputs zero for the next numSamples
+	void silenceLane(int k, int numSamples);
+	// Operator::processSample for every lane: modulation and output hold one value per lane
+	template <SineMode Mode>
+	void process(const Floats& modulation, Floats& output, int t);
+};
+
+// Defined here rather than in Operator.cpp so the per-algorithm render kernels can inline them
+template <SineMode Mode>
+inline float Operator::processSample(float modSample, int t)
+{
+	if (waveform == Waveform::Noise)
+	{
+		jassert(noiseBlock != nullptr);
+		const float output = noiseBlock[t] * ampBuffer[size_t(t)];
+		lastSample = feedbackSmoothing * output + (1.f - feedbackSmoothing) * lastSample;
+		feedbackHistory[size_t(feedbackPos)] = lastSample;
+		if (++feedbackPos == feedbackDelay)
+			feedbackPos = 0;
+		return output;
+	}
+	if (feedback)
+		modSample += feedbackHistory[size_t(feedbackPos)] * 0.25f; // scaled feedback
+
+	// envelope and amplitude smoothing were rendered for the whole block in prepareBlock
+	const float amp = ampBuffer[size_t(t)];
+
+	// --- Apply modulation based on mode ---
+	float output = 0.f;
+	const float index = modIndexRamp ? modIndexRamp[t] : modulationIndex;
+
+	if (modulationType == ModulationType::FM)
+	{
+		// Frequency Modulation: modulate instantaneous frequency (Hz)
+		const float base = pitchRamp ? pitchRamp[t] * noteFrequency : baseFrequency;
+		float deviation = index * modSample * base;
+		float currentFreq = base + deviation;
+		if (currentFreq < 0.f) currentFreq = 0.f;
+		setFrequency(currentFreq);
+		output = osc.nextSample<Mode>() * amp;
+	}
+	else // ModulationType::PM
+	{
+		// Phase Modulation (DX7-style): modulate phase angle directly
+		// The base frequency only moves while the pitch is ramping
+		if (pitchRamp)
+			setFrequency(pitchRamp[t] * noteFrequency);
+		// Scale modulator output to radians (modulationIndex controls depth)
+		float phaseOffsetRadians = index * modSample;
+		output = osc.nextSample<Mode>(phaseOffsetRadians) * amp;
+	}
+
+	lastSample = feedbackSmoothing * output + (1.f - feedbackSmoothing) * lastSample; // mild smoothing for feedback tone
+	feedbackHistory[size_t(feedbackPos)] = lastSample;
+	if (++feedbackPos == feedbackDelay)
+		feedbackPos = 0;
+	return output;
+}
+
+template <SineMode Mode>
+inline void Operator::processLanes(const float* modulation, float* output, int numLanes, int t)
+{
+	jassert(numLanes <= maxUnison);
+	// All maxUnison lanes run, so the loops have a fixed trip count and vectorise; extra lanes
+	// cost nothing in a full SIMD register. std::sin is scalar, so the exact engine runs only numLanes
+	const int count = Mode == SineMode::Exact ? numLanes : maxUnison;
+	const float amp = ampBuffer[size_t(t)];
+	const float index = modIndexRamp ? modIndexRamp[t] : modulationIndex;
+	const float feedbackGain = feedback ? 0.25f : 0.f; // scaled feedback
+	auto& history = laneFeedbackHistory[size_t(feedbackPos)]; // read, then overwritten with this sample's
+	// Locals, so the compiler need not fear the pointers alias the lane state
+	alignas(32) std::array<float, maxUnison> input, result{};
+	std::copy(modulation, modulation + maxUnison, input.begin());
+
+	if (waveform == Waveform::Noise)
+	{
+		jassert(laneNoiseBlock != nullptr);
+		const float* noise = laneNoiseBlock + t * maxUnison;
+		for (size_t k = 0; k < size_t(maxUnison); ++k)
+			result[k] = noise[k] * amp;
+	}
+	else if (modulationType == ModulationType::PM && pitchRamp == nullptr)
+	{
+		// Phase Modulation at a steady pitch: no branches, so the lanes run side by side
+		for (size_t k = 0; k < size_t(count); ++k)
+		{
+			const float phaseOffsetRadians = index * (input[k] + history[k] * feedbackGain);
+			result[k] = FastSine::sine<Mode>(lanePhase[k] + FastSine::radiansToPhaseWrapped(phaseOffsetRadians)) * amp;
+			lanePhase[k] += laneIncrement[k];
+		}
+	}
+	else
+	{
+		const float base = pitchRamp ? pitchRamp[t] * noteFrequency : baseFrequency;
+		const double phasePerHz = FastSine::cycleToPhase / double(sampleRate);
+		for (size_t k = 0; k < size_t(count); ++k)
+		{
+			const float modSample = input[k] + history[k] * feedbackGain;
+			float frequency = base * laneDetune[k];
+			uint32_t phase = lanePhase[k];
+			if (modulationType == ModulationType::FM)
+				frequency = juce::jmax(0.f, frequency + index * modSample * frequency);
+			else
+				phase += FastSine::radiansToPhase(index * modSample);
+			result[k] = FastSine::sine<Mode>(phase) * amp;
+			lanePhase[k] += uint32_t(int64_t(double(frequency) * phasePerHz));
+		}
+	}
+
+	for (size_t k = 0; k < size_t(maxUnison); ++k)
+	{
+		laneLastSample[k] = feedbackSmoothing * result[k] + (1.f - feedbackSmoothing) * laneLastSample[k];
+		history[k] = laneLastSample[k];
+	}
+	std::copy(result.begin(), result.end(), output);
+	if (++feedbackPos == feedbackDelay)
+		feedbackPos = 0;
+}
+
+template <SineMode Mode>
+inline void OperatorLanes::process(const Floats& modulation, Floats& output, int t)
+{
+	// The same steps as processSample's phase modulation, in the same order, so a lane renders exactly what
+	// the voice would alone
+	auto& history = feedbackHistory[size_t(feedbackPos)];
+	alignas(32) Floats radians = modulation;
+	if (feedback)
+	{
+		for (size_t k = 0; k < size_t(width); ++k)
+			radians[k] += history[k] * 0.25f; // scaled feedback
+	}
+	if (modIndexRamp)
+	{
+		const float index = modIndexRamp[t];
+		for (size_t k = 0; k < size_t(width); ++k)
+			radians[k] *= index;
+	}
+	else
+	{
+		for (size_t k = 0; k < size_t(width); ++k)
+			radians[k] *= modIndex[k];
+	}
+	if (pitchRamp)
+	{
+		const float pitch = pitchRamp[t];
+		for (size_t k = 0; k < size_t(width); ++k)
+			increment[k] = FastSine::frequencyToIncrement(pitch * noteFrequency[k], sampleRate);
+	}
+	// Locals, so the compiler need not fear output or history alias the lane state
+	const Floats& gain = amp[size_t(t)];
+	alignas(32) Floats result, smoothed;
+	for (size_t k = 0; k < size_t(width); ++k)
+	{
+		result[k] = FastSine::sineVectorised<Mode>(phase[k] + FastSine::radiansToPhaseVectorised(radians[k])) * gain[k];
+		phase[k] += increment[k];
+	}
+	for (size_t k = 0; k < size_t(width); ++k)
+		smoothed[k] = smoothing[k] * result[k] + (1.f - smoothing[k]) * lastSample[k];
+	lastSample = smoothed;
+	history = smoothed;
+	output = result;
+	if (++feedbackPos == feedbackDelay)
+		feedbackPos = 0;
+}
+
 // dummy carrier inheritings from operator, overloads getNextSample to not modulate but average over all "modulators"
 // 
 // class DummyCarrier : public Operator
@@ -11,6 +11,7 @@
 #pragma once
 #include <cmath>
 #include <JuceHeader.h>
+#include "FastSine.h"
 const float TWO_PI = 6.2831853071795864f;
 class Oscillator {
 public:
@@ -23,25 +24,26 @@ public:
     void reset()
     {
 //        sampleIndex = 0;
-        phase = 0.0f;
+        phase = 0;
     }
     
-    // Render sample with optional phase modulation offset (in radians)
+    // Render sample with optional phase modulation offset (in radians).
+    // Phase is a 32-bit fixed-point fraction of a cycle, so wrapping is just integer overflow.
+    template <SineMode Mode = SineMode::Exact>
     float nextSample(float phaseOffsetRadians = 0.0f)
     {
-        // Compute modulated phase (normalized 0-1 + offset converted from radians)
-        float modulatedPhase = phase + (phaseOffsetRadians / TWO_PI);
-        
-        // Wrap to [0, 1) range
-        modulatedPhase = modulatedPhase - std::floor(modulatedPhase);
+        // Compute modulated phase
+        const uint32_t modulatedPhase = phase + FastSine::radiansToPhase(phaseOffsetRadians);
         
         // Advance carrier phase
         phase += inc;
-        if (phase >= 1.0f) {
-            phase -= 1.0f;
-        }
         
-        return std::sin(TWO_PI * modulatedPhase);
+        return FastSine::sine<Mode>(modulatedPhase);
+    }
+    // Advance the phase without rendering
+    void advance(int numSamples)
+    {
+        phase += inc * uint32_t(numSamples);
     }
     float getFrequency()
     {
@@ -50,16 +52,20 @@ public:
     void setFrequency(float freq_, float sampleRate)
     {
         freq = freq_;
-        inc = freq / sampleRate;
+        inc = FastSine::frequencyToIncrement(freq, sampleRate);
     }
     float getPhase()
     {
-		return phase;
+		return float(phase) * FastSine::phaseToCycle;
     }
+    // The phase as a 32-bit fraction of a cycle, to hand it to and from the unison lanes
+    uint32_t getPhaseWord() const { return phase; }
+    uint32_t getIncrement() const { return inc; }
+    void setPhaseWord(uint32_t newPhase) { phase = newPhase; }
 private:
-    float phase;
+    uint32_t phase = 0;
 
-    float freq;
-    float inc;
+    float freq = 0.f;
+    uint32_t inc = 0;
 
 };
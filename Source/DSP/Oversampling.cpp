@@ -0,0 +1,234 @@
+/*
+  ==============================================================================
+
+    Oversampling.cpp
+
+  ==============================================================================
+*/
+
+#include "Oversampling.h"
+#include <cmath>
+
+namespace
+{
+    // Zeroth-order modified Bessel function, for the Kaiser window
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 50; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+}
+
+//==============================================================================
+HalfbandDecimator::HalfbandDecimator(int halfLength_, double kaiserBeta)
+    : halfLength(halfLength_)
+{
+    jassert(halfLength > 0);
+    // Nonzero taps sit at odd offsets m from the centre; tap i of the odd branch is offset 2K - 1 - 2i
+    const int numOdd = 2 * halfLength;
+    const double edge = 2.0 * halfLength;
+    std::vector<double> taps(static_cast<size_t>(numOdd));
+    double sum = 0.0;
+    for (int i = 0; i < numOdd; ++i)
+    {
+        const int m = 2 * halfLength - 1 - 2 * i;
+        const double window = besselI0(kaiserBeta * std::sqrt(1.0 - (m / edge) * (m / edge))) / besselI0(kaiserBeta);
+        taps[size_t(i)] = std::sin(juce::MathConstants<double>::pi * m / 2.0) / (juce::MathConstants<double>::pi * m) * window;
+        sum += taps[size_t(i)];
+    }
+    // Unity gain at DC: the centre tap contributes 0.5, the odd taps the other half
+    oddTaps.resize(size_t(numOdd));
+    for (int i = 0; i < numOdd; ++i)
+        oddTaps[size_t(i)] = float(taps[size_t(i)] * 0.5 / sum);
+}
+
+void HalfbandDecimator::prepare(int maxOutputSamples)
+{
+    even.assign(size_t(halfLength + maxOutputSamples), 0.0f);
+    odd.assign(size_t(2 * halfLength + maxOutputSamples), 0.0f);
+}
+
+void HalfbandDecimator::reset()
+{
+    std::fill(even.begin(), even.end(), 0.0f);
+    std::fill(odd.begin(), odd.end(), 0.0f);
+    silentSamples = 2 * halfLength;
+}
+
+void HalfbandDecimator::copyStateFrom(const HalfbandDecimator& other)
+{
+    jassert(other.halfLength == halfLength && other.even.size() == even.size());
+    std::copy(other.even.begin(), other.even.end(), even.begin());
+    std::copy(other.odd.begin(), other.odd.end(), odd.begin());
+    silentSamples = other.silentSamples;
+}
+
+void HalfbandDecimator::process(const float* input, float* output, int numOutputSamples)
+{
+    const int n = numOutputSamples;
+    jassert(size_t(halfLength + n) <= even.size());
+    if (input == nullptr && silentSamples >= 2 * halfLength)
+    {
+        juce::FloatVectorOperations::clear(output, n); // history is all zeros
+        return;
+    }
+    float* evenIn = even.data() + halfLength;
+    float* oddIn = odd.data() + 2 * halfLength;
+    if (input != nullptr)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            evenIn[i] = input[2 * i];
+            oddIn[i] = input[2 * i + 1];
+        }
+        silentSamples = 0;
+    }
+    else
+    {
+        juce::FloatVectorOperations::clear(evenIn, n);
+        juce::FloatVectorOperations::clear(oddIn, n);
+        silentSamples += n;
+    }
+
+    // y[t] = 0.5 * even[t - K] + sum_i oddTaps[i] * odd[t - 1 - i]
+    juce::FloatVectorOperations::copyWithMultiply(output, even.data(), 0.5f, n);
+    const int numOdd = 2 * halfLength;
+    for (int i = 0; i < numOdd; ++i)
+        juce::FloatVectorOperations::addWithMultiply(output, oddIn - 1 - i, oddTaps[size_t(i)], n);
+
+    // Keep the newest samples as history for the next block
+    std::copy(even.begin() + n, even.begin() + n + halfLength, even.begin());
+    std::copy(odd.begin() + n, odd.begin() + n + 2 * halfLength, odd.begin());
+}
+
+//==============================================================================
+void BlockDelay::prepare(int maxDelay, int maxSamples)
+{
+    line.assign(size_t(maxDelay + maxSamples), 0.0f);
+    reset();
+}
+
+void BlockDelay::reset()
+{
+    std::fill(line.begin(), line.end(), 0.0f);
+    silentSamples = delay;
+}
+
+void BlockDelay::copyStateFrom(const BlockDelay& other)
+{
+    jassert(other.line.size() == line.size());
+    std::copy(other.line.begin(), other.line.end(), line.begin());
+    delay = other.delay;
+    silentSamples = other.silentSamples;
+}
+
+void BlockDelay::setDelay(int numSamples)
+{
+    jassert(numSamples >= 0 && (line.empty() || size_t(numSamples) < line.size())); // may be set before prepare()
+    delay = numSamples;
+    reset();
+}
+
+void BlockDelay::addTo(const float* input, float* output, int numSamples)
+{
+    const int n = numSamples;
+    jassert(size_t(delay + n) <= line.size());
+    if (input == nullptr)
+    {
+        if (silentSamples >= delay)
+            return;
+        juce::FloatVectorOperations::clear(line.data() + delay, n);
+        silentSamples += n;
+    }
+    else
+    {
+        juce::FloatVectorOperations::copy(line.data() + delay, input, n);
+        silentSamples = 0;
+    }
+    juce::FloatVectorOperations::add(output, line.data(), n);
+    std::copy(line.begin() + n, line.begin() + n + delay, line.begin());
+}
+
+//==============================================================================
+VoiceDecimator::VoiceDecimator()
+    : finalStage(16, 8.0),  // passband ripple < 0.001 dB to 20 kHz, > 80 dB rejection from 28 kHz at 48 kHz
+      firstStage(6, 8.0)    // > 80 dB rejection where it folds onto the audio band
+{
+}
+
+void VoiceDecimator::prepare(int maxOutputSamples)
+{
+    finalStage.prepare(maxOutputSamples);
+    firstStage.prepare(2 * maxOutputSamples);
+    baseDelay.prepare(getLatency(maxFactor), maxOutputSamples);
+    midDelay.prepare(firstStage.getLatency(), 2 * maxOutputSamples);
+    intermediate.assign(size_t(2 * maxOutputSamples), 0.0f);
+    baseDelay.setDelay(getLatency());
+    midDelay.setDelay(firstStage.getLatency());
+}
+
+void VoiceDecimator::reset()
+{
+    finalStage.reset();
+    firstStage.reset();
+    baseDelay.reset();
+    midDelay.reset();
+}
+
+void VoiceDecimator::setFactor(int newFactor)
+{
+    jassert(newFactor == 1 || newFactor == 2 || newFactor == 4);
+    if (newFactor == factor)
+        return;
+    factor = newFactor;
+    baseDelay.setDelay(getLatency());
+    reset();
+}
+
+void VoiceDecimator::copyStateFrom(const VoiceDecimator& other)
+{
+    finalStage.copyStateFrom(other.finalStage);
+    firstStage.copyStateFrom(other.firstStage);
+    baseDelay.copyStateFrom(other.baseDelay);
+    midDelay.copyStateFrom(other.midDelay);
+    factor = other.factor;
+}
+
+void VoiceDecimator::process(const std::array<const float*, numRates>& inputs, float* output, int numOutputSamples)
+{
+    const int n = numOutputSamples;
+    switch (factor)
+    {
+        case 4:
+            // The 2x sum joins the 4x sum after the first stage, delayed by that stage's latency
+            firstStage.process(inputs[2], intermediate.data(), 2 * n);
+            midDelay.addTo(inputs[1], intermediate.data(), 2 * n);
+            finalStage.process(intermediate.data(), output, n);
+            break;
+        case 2:
+            jassert(inputs[2] == nullptr);
+            finalStage.process(inputs[1], output, n);
+            break;
+        default:
+            jassert(inputs[1] == nullptr && inputs[2] == nullptr);
+            juce::FloatVectorOperations::clear(output, n);
+            break;
+    }
+    baseDelay.addTo(inputs[0], output, n);
+}
+
+int VoiceDecimator::getLatency(int forFactor) const
+{
+    // The first stage's latency is counted at 2x, where it is always even
+    switch (forFactor)
+    {
+        case 4:  return finalStage.getLatency() + firstStage.getLatency() / 2;
+        case 2:  return finalStage.getLatency();
+        default: return 0;
+    }
+}
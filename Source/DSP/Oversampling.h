@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    Oversampling.h
+
+    Decimation for the oversampled voice core. The voices render at 2x or 4x
+    the host rate; the voice sum is brought back down once per block by
+    halfband FIR stages (4x uses two), never per voice.
+
+    Each stage is polyphase: the even input samples only pass through a
+    delay, the odd ones through the symmetric half of the filter. The filter
+    runs one tap at a time across the whole block with FloatVectorOperations,
+    so the inner loops are SIMD. Stages read their output at the phase that
+    makes the latency a whole number of host-rate samples.
+
+    With adaptive oversampling the voices are summed per render rate. Each
+    sum enters the chain at the stage for its rate and lower rates are
+    delayed to match, so every path has the same latency and a voice can
+    move between rates without a jump in time.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+
+/* HalfbandDecimator halves the sample rate with a Kaiser-windowed halfband FIR. */
+class HalfbandDecimator
+{
+public:
+    /*
+    halfLength (K) sets the filter: 4K - 1 taps, 2K of them nonzero besides the centre.
+    Latency is K output samples.
+    */
+    HalfbandDecimator(int halfLength, double kaiserBeta);
+
+    /// Allocates for blocks of up to maxOutputSamples. Not real-time safe.
+    void prepare(int maxOutputSamples);
+    void reset();
+    /// Takes over the history of other, prepared for the same block size. Real-time safe.
+    void copyStateFrom(const HalfbandDecimator& other);
+
+    /// Decimates 2 * numOutputSamples input samples. input and output may not overlap.
+    /// A null input is silence; once the filter has drained, silent blocks cost nothing.
+    void process(const float* input, float* output, int numOutputSamples);
+
+    int getLatency() const { return halfLength; }
+
+private:
+    const int halfLength;
+    std::vector<float> oddTaps;  // taps applied to the odd input samples, 2K of them
+    std::vector<float> even;     // halfLength samples of history, then the block's even samples
+    std::vector<float> odd;      // 2 * halfLength samples of history, then the block's odd samples
+    int silentSamples = 0;       // output samples since the last non-null input
+};
+
+/* BlockDelay delays a signal by a whole number of samples and adds it to a buffer. */
+class BlockDelay
+{
+public:
+    /// Allocates for delays up to maxDelay and blocks up to maxSamples. Not real-time safe.
+    void prepare(int maxDelay, int maxSamples);
+    void reset();
+    /// Takes over the delay and the line of other, prepared alike. Real-time safe.
+    void copyStateFrom(const BlockDelay& other);
+    /// Changes the delay and clears the line.
+    void setDelay(int numSamples);
+
+    /// Adds input, delayed, to output. A null input is silence.
+    void addTo(const float* input, float* output, int numSamples);
+
+private:
+    std::vector<float> line;  // delay samples of history, then the block
+    int delay = 0;
+    int silentSamples = 0;
+};
+
+/* VoiceDecimator takes the voice sums down to the host rate, for a highest factor of 1, 2 or 4. */
+class VoiceDecimator
+{
+public:
+    static constexpr int maxFactor = 4;
+    static constexpr int numRates = 3;  // voice sums at 1x, 2x and 4x
+
+    VoiceDecimator();
+
+    void prepare(int maxOutputSamples);
+    void reset();
+
+    /// Changes the highest factor and clears the filter state.
+    void setFactor(int newFactor);
+    /// Takes over the factor and filter state of other, prepared for the same block size, so both
+    /// go on to produce the same output. Real-time safe.
+    void copyStateFrom(const VoiceDecimator& other);
+    int getFactor() const { return factor; }
+
+    /*
+    process takes one voice sum per rate, inputs[r] holding (1 << r) * numOutputSamples
+    samples, and writes their sum at the host rate. Rates above the factor must be null;
+    a null input is silence. At factor 1 this is a copy.
+    */
+    void process(const std::array<const float*, numRates>& inputs, float* output, int numOutputSamples);
+
+    /// Latency in host-rate samples at the current factor, the same for every input.
+    int getLatency() const { return getLatency(factor); }
+    int getLatency(int forFactor) const;
+
+private:
+    HalfbandDecimator finalStage;   // 2x -> 1x, the steep one
+    HalfbandDecimator firstStage;   // 4x -> 2x, only needs to protect the audio band
+    BlockDelay baseDelay;           // aligns the 1x sum with the filtered ones
+    BlockDelay midDelay;            // aligns the 2x sum with the first stage's output
+    std::vector<float> intermediate;
+    int factor = 1;
+};
@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    Smoothing.h
+
+    Block-wise parameter ramps. A BlockSmoother turns a parameter change into a
+    ramp and renders it a block at a time, as a vector the block renderers read
+    per sample. A parameter that is not moving renders nothing: process()
+    returns nullptr and the renderer keeps using its scalar value.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <cmath>
+
+class BlockSmoother
+{
+public:
+    enum class Curve
+    {
+        Linear,      // equal steps, for levels and depths
+        Exponential  // equal ratios, for frequencies; values must stay above zero
+    };
+
+    explicit BlockSmoother(Curve curve_ = Curve::Linear) : curve(curve_) {}
+
+    /*
+    reset sets the ramp length and stops any ramp in progress. The next setTarget
+    jumps straight to its value, so a freshly prepared processor does not glide
+    in from a default.
+    */
+    void reset(double sampleRate, double rampSeconds) noexcept
+    {
+        rampLength = juce::jmax(0, juce::roundToInt(sampleRate * rampSeconds));
+        samplesLeft = 0;
+        current = target;
+        snapNextTarget = true;
+    }
+
+    /*
+    setSampleRate changes the ramp length for a new rate without a jump: a ramp in
+    progress keeps its remaining time and lands on the same target.
+    */
+    void setSampleRate(double sampleRate, double rampSeconds) noexcept
+    {
+        const int newLength = juce::jmax(0, juce::roundToInt(sampleRate * rampSeconds));
+        if (samplesLeft > 0)
+        {
+            samplesLeft = newLength > 0 ? juce::jmax(1, juce::roundToInt(double(samplesLeft) * newLength / rampLength)) : 0;
+            if (samplesLeft == 0)
+                current = target;
+            else
+                step = (curve == Curve::Linear)
+                    ? (target - current) / float(samplesLeft)
+                    : std::pow(target / current, 1.0f / float(samplesLeft));
+        }
+        rampLength = newLength;
+    }
+
+    void setTarget(float newTarget) noexcept
+    {
+        if (newTarget == target && !snapNextTarget)
+            return;
+        target = newTarget;
+        const bool canRamp = rampLength > 0 && !snapNextTarget
+            && (curve == Curve::Linear || (current > 0.0f && target > 0.0f));
+        snapNextTarget = false;
+        if (!canRamp || current == target)
+        {
+            current = target;
+            samplesLeft = 0;
+            return;
+        }
+        samplesLeft = rampLength;
+        step = (curve == Curve::Linear)
+            ? (target - current) / float(rampLength)
+            : std::pow(target / current, 1.0f / float(rampLength));
+    }
+
+    void setCurrentAndTarget(float value) noexcept
+    {
+        current = target = value;
+        samplesLeft = 0;
+        snapNextTarget = false;
+    }
+
+    bool isRamping() const noexcept { return samplesLeft > 0; }
+    float getCurrent() const noexcept { return current; }
+    float getTarget() const noexcept { return target; }
+
+    /*
+    process writes the next numSamples values of the ramp to buffer and returns it,
+    or returns nullptr without touching buffer when the parameter is static. The
+    ramp lands exactly on the target; the rest of the block holds it.
+    */
+    const float* process(float* buffer, int numSamples) noexcept
+    {
+        if (samplesLeft == 0)
+            return nullptr;
+
+        const int run = juce::jmin(numSamples, samplesLeft);
+        float value = current;
+        if (curve == Curve::Linear)
+        {
+            for (int i = 0; i < run; ++i)
+            {
+                value += step;
+                buffer[i] = value;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < run; ++i)
+            {
+                value *= step;
+                buffer[i] = value;
+            }
+        }
+        samplesLeft -= run;
+        if (samplesLeft == 0)
+        {
+            value = target;
+            std::fill(buffer + run - 1, buffer + numSamples, target);
+        }
+        current = value;
+        return buffer;
+    }
+
+private:
+    Curve curve;
+    float current = 0.0f;
+    float target = 0.0f;
+    float step = 0.0f;      // added (linear) or multiplied (exponential) per sample
+    int rampLength = 0;
+    int samplesLeft = 0;
+    bool snapNextTarget = true;
+};
@@ -14,44 +14,148 @@ Synth::Synth()
     : voiceHandler(8)   // initialize with a default polyphony of 8 voices
 {
     // Previously: voice.init();
-    // No additional initialization needed here—the VoiceHandler constructor builds the voices.
+    // The voice pool itself is built in allocateResources, off the audio thread.
+    rampBlockSize = Operator::maxBlockSize;
+    rampBufferSize = rampBlockSize * VoiceDecimator::maxFactor;
+    rampStorage.assign(size_t(numRates * numRampBuffers * rampBufferSize), 0.0f);
 }
 
-void Synth::allocateResources(double sampleRate_, int /*samplesPerBlock*/)
+void Synth::allocateResources(double sampleRate_, int samplesPerBlock)
 {
     sampleRate = static_cast<float>(sampleRate_);
-    // Reset all voices in the polyphonic bank with the new sample rate.
-    voiceHandler.reset(sampleRate);
+    // Allocate the full pool once so any polyphony setting can be used without allocating,
+    // and reset all voices with the new sample rate.
+    // Ramps cover a whole host block, so voices (and render workers) get the block in one piece
+    rampBlockSize = juce::jmax(Operator::maxBlockSize, samplesPerBlock);
+    rampBufferSize = rampBlockSize * VoiceDecimator::maxFactor;
+    voiceHandler.prepare(VoiceHandler::maxVoices, sampleRate, rampBlockSize);
+    rampStorage.assign(size_t(numRates * numRampBuffers * rampBufferSize), 0.0f);
+    voiceSums.assign(size_t(2 * numRates * rampBufferSize), 0.0f);
+    decimator.prepare(rampBlockSize);
+    decimator.reset();
+    decimatorRight.prepare(rampBlockSize);
+    decimatorRight.reset();
+    outgoingDecimator.prepare(rampBlockSize);
+    outgoingDecimatorRight.prepare(rampBlockSize);
+    outgoingOutput.assign(size_t(2 * rampBlockSize), 0.0f);
+    modulationStorage.assign(size_t(ModTarget::numTargets * rampBufferSize), 0.0f);
+    globalModulation.setSampleRate(getVoiceSampleRate(), oversampling);
+    globalModulation.reset();
+    for (auto& op : smoothers)
+    {
+        op.level.reset(getVoiceSampleRate(), parameterRampSeconds);
+        op.modIndex.reset(getVoiceSampleRate(), parameterRampSeconds);
+        op.pitch.reset(getVoiceSampleRate(), parameterRampSeconds);
+    }
 }
 
 void Synth::deallocateResources()
 {
-    // do nothing
+    voiceHandler.releaseResources();
 }
 
 void Synth::reset()
 {
+    // No note survives a reset, so a pending change of oversampling completes at once
+    chainFadePosition = -1;
+    setVoiceOversampling(targetOversampling);
+    setRampOversampling(targetOversampling);
+    decimator.setFactor(targetOversampling);
+    decimatorRight.setFactor(targetOversampling);
     voiceHandler.reset(sampleRate);
-    //noiseGen.reset();
+    decimator.reset();
+    decimatorRight.reset();
+    globalModulation.reset();
 }
 
 void Synth::render(float** outputBuffers, int sampleCount)
 {
     float* outputBufferLeft = outputBuffers[0];
     float* outputBufferRight = outputBuffers[1];
-
-    for (int sample = 0; sample < sampleCount; ++sample)
+    // Only a unison stack spread in stereo renders two channels; everything else is mono
+    const bool stereo = outputBufferRight != nullptr && voiceHandler.isStereo();
+    if (stereo && !renderedStereo)
     {
-        // Mix the output from all active voices.
-        float output = voiceHandler.getNextSample();
-        outputBufferLeft[sample] = output;
+        // Only fed while in stereo. The right channel carries on from the mono one, which both channels played until now
+        decimatorRight.copyStateFrom(decimator);
+        outgoingDecimatorRight.copyStateFrom(outgoingDecimator);
+    }
+    renderedStereo = stereo;
 
-        if (outputBufferRight != nullptr)
+    // Mix the output from all active voices, in chunks short enough for the ramp buffers.
+    // When oversampling, the voices render the chunk at their rate and only the sums are decimated.
+    for (int start = 0; start < sampleCount; start += rampBlockSize)
+    {
+        const int numSamples = juce::jmin(rampBlockSize, sampleCount - start);
+        advanceOversampling();
+        if (oversampling == 1 && chainFadePosition < 0)
+        {
+            VoiceHandler::RateOutputs right {};
+            if (stereo)
+                right[0] = outputBufferRight + start;
+            lastRatesUsed = voiceHandler.renderBlock({ outputBufferLeft + start, nullptr, nullptr }, numSamples,
+                                                     processRamps(numSamples), right);
+            continue;
+        }
+        VoiceHandler::RateOutputs sums {}, rightSums {};
+        for (int rate = 0; (1 << rate) <= oversampling; ++rate)
         {
-            outputBufferRight[sample] = output;
+            sums[size_t(rate)] = voiceSums.data() + rate * rampBufferSize;
+            if (stereo)
+                rightSums[size_t(rate)] = voiceSums.data() + (numRates + rate) * rampBufferSize;
         }
-        voiceHandler.resetCaches();
+        const int ratesUsed = voiceHandler.renderBlock(sums, numSamples, processRamps(numSamples), rightSums);
+        lastRatesUsed = ratesUsed;
+        // Rates no voice used are passed as silence, so idle filter stages drain and then stop
+        std::array<const float*, numRates> inputs {}, rightInputs {};
+        for (int rate = 0; rate < numRates; ++rate)
+        {
+            inputs[size_t(rate)] = ((ratesUsed >> rate) & 1) ? sums[size_t(rate)] : nullptr;
+            rightInputs[size_t(rate)] = ((ratesUsed >> rate) & 1) ? rightSums[size_t(rate)] : nullptr;
+        }
+        decimator.process(inputs, outputBufferLeft + start, numSamples);
+        if (stereo)
+            decimatorRight.process(rightInputs, outputBufferRight + start, numSamples);
+        if (chainFadePosition >= 0)
+            crossfadeChains(inputs, rightInputs, outputBufferLeft + start, stereo ? outputBufferRight + start : nullptr,
+                            numSamples);
+    }
+
+    if (outputBufferRight != nullptr && !stereo)
+    {
+        juce::FloatVectorOperations::copy(outputBufferRight, outputBufferLeft, sampleCount);
     }
+    reportModulationCost();
+}
+
+void Synth::reportModulationCost()
+{
+    const auto& matrix = voiceHandler.getModMatrix();
+    auto& cost = voiceHandler.getModulationCost();
+    for (size_t s = 0; s < ModMatrix::numSources; ++s)
+    {
+        reportedRoutes[s].store(matrix.getRoutes(ModSource(s + 1)).size, std::memory_order_relaxed);
+        if (cost.points[s] == 0)
+            continue;
+        reportedModulationTicks[s].fetch_add(cost.ticks[s], std::memory_order_relaxed);
+        reportedModulationPoints[s].fetch_add(cost.points[s], std::memory_order_relaxed);
+    }
+    cost.clear();
+}
+
+ModulationLoad Synth::takeModulationLoad()
+{
+    ModulationLoad load;
+    const double microsecondsPerTick = 1.0e6 / double(juce::Time::getHighResolutionTicksPerSecond());
+    for (size_t s = 0; s < ModMatrix::numSources; ++s)
+    {
+        load.routes[s] = reportedRoutes[s].load(std::memory_order_relaxed);
+        const auto ticks = reportedModulationTicks[s].exchange(0, std::memory_order_relaxed);
+        const auto points = reportedModulationPoints[s].exchange(0, std::memory_order_relaxed);
+        if (points > 0 && load.routes[s] > 0)
+            load.microsecondsPerPoint[s] = double(ticks) * microsecondsPerTick / double(points * load.routes[s]);
+    }
+    return load;
 }
 
 void Synth::noteOn(int note, int velocity)
@@ -69,23 +173,151 @@ void Synth::updateAlgorithm(int algIndex_)
 {
     voiceHandler.updateAlgorithm(algIndex_);
 }
+void Synth::setAlgorithmSwitchMode(AlgSwitchMode mode)
+{
+    voiceHandler.setAlgorithmSwitchMode(mode);
+}
+void Synth::setCycleCaching(bool enabled)
+{
+    voiceHandler.setCycleCaching(enabled);
+}
+void Synth::setUnison(int numVoices, float detuneCents, float spread)
+{
+    voiceHandler.setUnison(numVoices, detuneCents, spread);
+}
+void Synth::setSineMode(SineMode mode)
+{
+    voiceHandler.setSineMode(mode);
+}
+void Synth::setMatrixMode(bool enabled)
+{
+    voiceHandler.setMatrixMode(enabled);
+}
+void Synth::setMatrixAlgorithm(const MatrixAlgorithm& matrix)
+{
+    voiceHandler.setMatrixAlgorithm(matrix);
+}
 void Synth::updateOsc(float fine, float coarse, float level, float ratio, float modIndex, int index)
 {
+    // The operators jump to the new values; while the smoothers ramp, the ramps
+    // handed to renderBlock take precedence and end on the same values.
+    const float pitchScale = ratio * pitchOffsets.getMultiplier(coarse, fine);
+    smoothers[index].level.setTarget(level);
+    smoothers[index].modIndex.setTarget(modIndex);
+    smoothers[index].pitch.setTarget(pitchScale);
+
     // In a polyphonic setting, apply oscillator adjustments
     // to the operator with the specified index for all voices.
-    //
-    // Here we assume that VoiceHandler exposes its voice vector
-    // via a getter like getVoices(). Adjust as needed.
     for (auto& voice : voiceHandler.getVoices())
     {
-        // Adjust the operator parameters in each voice.
-        // (It is assumed that each Voice contains an array of operators called op.)
-        voice.op[index].updateTuning(fine, coarse);
-        voice.op[index].updateRatio(ratio);
+        voice.op[index].setPitchScale(pitchScale);
         voice.op[index].updateLevel(level);
         voice.op[index].setModulationIndex(modIndex);
     }
 }
+void Synth::setWaveform(Waveform waveform, int index)
+{
+    for (auto& voice : voiceHandler.getVoices())
+        voice.op[index].setWaveform(waveform);
+}
+
+VoiceHandler::RateRamps Synth::processRamps(int numSamples)
+{
+    // numSamples is at the host rate; the smoothers run at the highest voice rate
+    const int topRate = getRate(oversampling);
+    const int numTopSamples = numSamples << topRate;
+    VoiceHandler::RateRamps ramps;
+    auto& top = ramps[size_t(topRate)];
+    for (size_t i = 0; i < smoothers.size(); ++i)
+    {
+        float* buffers = getRampBuffer(topRate, 3 * int(i));
+        top[i].level = smoothers[i].level.process(buffers, numTopSamples);
+        top[i].modIndex = smoothers[i].modIndex.process(buffers + rampBufferSize, numTopSamples);
+        top[i].pitch = smoothers[i].pitch.process(buffers + 2 * rampBufferSize, numTopSamples);
+    }
+    applyGlobalModulation(top, numTopSamples);
+    // Fixed oversampling renders every voice at the top rate, except while the factor changes
+    const bool belowTopRate = voiceOversampling != oversampling || (lastRatesUsed & ((1 << topRate) - 1)) != 0;
+    if (!adaptiveOversampling && !belowTopRate)
+        return ramps;
+
+    // Slower voices take every (1 << (topRate - rate))th value, the one at the end of each of their samples
+    for (int rate = 0; rate < topRate; ++rate)
+    {
+        const int stride = 1 << (topRate - rate);
+        const int numRateSamples = numSamples << rate;
+        for (size_t i = 0; i < smoothers.size(); ++i)
+        {
+            const float* source[3] = { top[i].level, top[i].modIndex, top[i].pitch };
+            const float* decimated[3] = {};
+            for (int k = 0; k < 3; ++k)
+            {
+                if (source[k] == nullptr)
+                    continue;
+                float* buffer = getRampBuffer(rate, 3 * int(i) + k);
+                for (int t = 0; t < numRateSamples; ++t)
+                    buffer[t] = source[k][t * stride + stride - 1];
+                decimated[k] = buffer;
+            }
+            ramps[size_t(rate)][i] = { decimated[0], decimated[1], decimated[2] };
+        }
+    }
+    return ramps;
+}
+
+void Synth::applyGlobalModulation(Voice::Ramps& ramps, int numSamples)
+{
+    const auto& matrix = voiceHandler.getModMatrix();
+    const auto& routes = matrix.getRoutes(ModSource::GlobalLfo);
+    float cutoff = 0.f;
+    if (!routes.isEmpty())
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+        const int numPoints = globalModulation.process(routes, matrix.getLfo(ModSource::GlobalLfo),
+                                                       matrix.getControlInterval(), numSamples,
+                                                       modulationStorage.data(), rampBufferSize);
+        float* buffer = modulationStorage.data();
+        for (const auto& route : routes)
+        {
+            if (route.target == ModTarget::cutoff)
+                cutoff = buffer[numSamples - 1];
+            else
+            {
+                // Static parameters sit on their smoother's target
+                const int i = route.target / ModTarget::numOperatorParams;
+                auto& r = ramps[size_t(i)];
+                auto& s = smoothers[size_t(i)];
+                switch (route.target % ModTarget::numOperatorParams)
+                {
+                    case ModTarget::level:
+                        r.level = ModTarget::applyToRamp(route.target, buffer, r.level, s.level.getTarget(), numSamples);
+                        break;
+                    case ModTarget::ratio:
+                        r.pitch = ModTarget::applyToRamp(route.target, buffer, r.pitch, s.pitch.getTarget(), numSamples);
+                        break;
+                    default:
+                        r.modIndex = ModTarget::applyToRamp(route.target, buffer, r.modIndex, s.modIndex.getTarget(), numSamples);
+                        break;
+                }
+            }
+            buffer += rampBufferSize;
+        }
+        voiceHandler.getModulationCost().add(ModSource::GlobalLfo, start, numPoints);
+    }
+    // The voice filters glide to it over the chunk, like a cutoff change
+    voiceHandler.getFilterBank().setModulation(cutoff);
+}
+
+void Synth::snapParameterRamps()
+{
+    for (auto& op : smoothers)
+    {
+        op.level.setCurrentAndTarget(op.level.getTarget());
+        op.modIndex.setCurrentAndTarget(op.modIndex.getTarget());
+        op.pitch.setCurrentAndTarget(op.pitch.getTarget());
+    }
+    voiceHandler.getFilterBank().snapToTargets();
+}
 
 void Synth::updateADSR(float attack, float decay, float sustain, float release, int index)
 {
@@ -97,6 +329,187 @@ void Synth::updateADSR(float attack, float decay, float sustain, float release,
     }
 }
 
+void Synth::setPolyphony(int numVoices)
+{
+    voiceHandler.setPolyphony(numVoices);
+}
+void Synth::setNumRenderThreads(int numThreads)
+{
+    voiceHandler.setNumRenderThreads(numThreads);
+}
+void Synth::setStealPolicy(StealPolicy policy)
+{
+    voiceHandler.setStealPolicy(policy);
+}
+void Synth::setLfo(int index, LfoShape shape, float rateHz)
+{
+    voiceHandler.getModMatrix().setLfo(index, shape, rateHz);
+}
+void Synth::setModulationRoute(int slot, ModSource source, int target, float amount)
+{
+    voiceHandler.getModMatrix().setRoute(slot, source, target, amount);
+}
+void Synth::setModulationControlInterval(int samples)
+{
+    voiceHandler.getModMatrix().setControlInterval(samples);
+}
+void Synth::setTuning(const TuningTable& tuning)
+{
+    voiceHandler.setTuning(tuning);
+}
+void Synth::setOversampling(int factor, bool adaptive)
+{
+    jassert(factor == 1 || factor == 2 || factor == 4);
+    if (factor == targetOversampling && adaptive == adaptiveOversampling)
+        return;
+    // Everything that counts samples follows the voice rates; nothing is stopped or reallocated
+    targetOversampling = factor;
+    adaptiveOversampling = adaptive;
+    voiceHandler.setOversampling(voiceOversampling, adaptive);
+    if (isIdle())
+    {
+        // Nothing sounds through the decimators: switch them at once
+        chainFadePosition = -1;
+        setVoiceOversampling(factor);
+        setRampOversampling(factor);
+        decimator.setFactor(factor);
+        decimatorRight.setFactor(factor);
+    }
+}
+
+/*
+advanceOversampling moves the voices and the decimation chain toward
+targetOversampling while notes sound, one step per chunk. Each chain has its own
+latency, and a cleared one starts from empty filters, so switching chains outright
+jumps. Instead both chains decimate the same voice sums for a while: the new one
+settles for decimatorSettleSamples, then the output crossfades to it (see
+crossfadeChains). Both chains must take every sum, so going down the voices first
+crossfade to the lower rate on their own (see VoiceHandler::startTransition) and the
+chain follows once none renders above it; going up the chain changes first.
+*/
+void Synth::advanceOversampling()
+{
+    if (chainFadePosition >= 0)
+        return;
+    if (targetOversampling > oversampling)
+        startChainChange();
+    else if (targetOversampling < oversampling)
+    {
+        setVoiceOversampling(targetOversampling);
+        if ((lastRatesUsed >> (getRate(targetOversampling) + 1)) == 0)
+            startChainChange();
+    }
+    else
+        setVoiceOversampling(targetOversampling);
+}
+
+void Synth::startChainChange()
+{
+    outgoingDecimator.copyStateFrom(decimator);
+    outgoingDecimatorRight.copyStateFrom(decimatorRight);
+    decimator.setFactor(targetOversampling);
+    decimatorRight.setFactor(targetOversampling);
+    setRampOversampling(targetOversampling);
+    chainFadePosition = 0;
+}
+
+// Runs the outgoing chain on the same sums and fades the output from it to the new chain's
+void Synth::crossfadeChains(const std::array<const float*, numRates>& inputs,
+                            const std::array<const float*, numRates>& rightInputs, float* left, float* right, int numSamples)
+{
+    const int fadeSamples = juce::jmax(1, juce::roundToInt(oversamplingFadeSeconds * sampleRate));
+    const float step = 1.0f / static_cast<float>(fadeSamples);
+    std::array<VoiceDecimator*, 2> chains { &outgoingDecimator, &outgoingDecimatorRight };
+    std::array<const std::array<const float*, numRates>*, 2> channelInputs { &inputs, &rightInputs };
+    std::array<float*, 2> outputs { left, right };
+    for (size_t channel = 0; channel < (right != nullptr ? 2u : 1u); ++channel)
+    {
+        float* outgoing = outgoingOutput.data() + channel * size_t(rampBlockSize);
+        chains[channel]->process(*channelInputs[channel], outgoing, numSamples);
+        float* output = outputs[channel];
+        for (int t = 0; t < numSamples; ++t)
+        {
+            const float gain = juce::jlimit(0.0f, 1.0f, static_cast<float>(chainFadePosition + t + 1 - decimatorSettleSamples) * step);
+            output[t] = outgoing[t] + gain * (output[t] - outgoing[t]);
+        }
+    }
+    chainFadePosition += numSamples;
+    if (chainFadePosition >= decimatorSettleSamples + fadeSamples)
+        chainFadePosition = -1;
+}
+
+void Synth::setVoiceOversampling(int factor)
+{
+    if (factor == voiceOversampling)
+        return;
+    voiceOversampling = factor;
+    voiceHandler.setOversampling(factor, adaptiveOversampling);
+}
+
+void Synth::setRampOversampling(int factor)
+{
+    if (factor == oversampling)
+        return;
+    oversampling = factor;
+    globalModulation.setSampleRate(getVoiceSampleRate(), oversampling);
+    for (auto& op : smoothers)
+    {
+        op.level.setSampleRate(getVoiceSampleRate(), parameterRampSeconds);
+        op.modIndex.setSampleRate(getVoiceSampleRate(), parameterRampSeconds);
+        op.pitch.setSampleRate(getVoiceSampleRate(), parameterRampSeconds);
+    }
+}
+void Synth::setEnvelopeCurve(Envelope::Curve curve)
+{
+    // The curve shape is shared by every operator envelope and the filter envelope
+    for (auto& voice : voiceHandler.getVoices())
+    {
+        for (auto& op : voice.op)
+            op.setEnvelopeCurve(curve);
+        for (auto* filter : { &voice.filter, &voice.filterRight })
+        {
+            Envelope::Parameters params = filter->env.getParameters();
+            params.curve = curve;
+            filter->env.setParameters(params);
+        }
+    }
+}
+void Synth::setVoiceFiltering(bool enabled)
+{
+    voiceHandler.setVoiceFiltering(enabled);
+}
+void Synth::setFilterCutoff(float frequencyHz)
+{
+    voiceHandler.getFilterBank().setCutoff(frequencyHz);
+}
+void Synth::setFilterResonance(float resonance)
+{
+    voiceHandler.getFilterBank().setResonance(resonance);
+}
+void Synth::setFilterKeyTracking(float amount)
+{
+    voiceHandler.getFilterBank().setKeyTracking(amount);
+}
+void Synth::setFilterEnvelopeAmount(float octaves)
+{
+    voiceHandler.getFilterBank().setEnvelopeAmount(octaves);
+}
+void Synth::updateFilterADSR(float attack, float decay, float sustain, float release)
+{
+    for (auto& voice : voiceHandler.getVoices())
+    {
+        for (auto* filter : { &voice.filter, &voice.filterRight })
+        {
+            Envelope::Parameters params = filter->env.getParameters();
+            params.attack = attack;
+            params.decay = decay;
+            params.sustain = sustain;
+            params.release = release;
+            filter->env.setParameters(params);
+        }
+    }
+}
+
 void Synth::midiMessage(uint8_t data0, uint8_t data1, uint8_t data2)
 {
     switch (data0 & 0xF0)
@@ -12,9 +12,13 @@
 
 
 #include <JuceHeader.h>
+#include <atomic>
 #include "Voice.h"
 #include "VoiceHandler.h"
-#include "NoiseGenerator.h"
+#include "Smoothing.h"
+#include "Oversampling.h"
+#include "Tuning.h"
+#include "Modulation.h"
 
 class Synth {
 public:
@@ -26,11 +30,106 @@ public:
     void midiMessage(uint8_t data0, uint8_t data1, uint8_t data2);
     void updateADSR(float attack, float decay, float sustain, float release, int index); // May need an additional int input for what oscillator is being updated depending on our desired topology
     void updateOsc(float fine, float coarse, float level, float ratio, float modIndex, int index);
+    // A Noise operator plays its voice's white noise in place of the sine, e.g. for breath or a percussive attack
+    void setWaveform(Waveform waveform, int index);
     void updateAlgorithm(int algIndex_);
+    // How sounding notes follow an algorithm change: at once, not at all, or with a short crossfade
+    void setAlgorithmSwitchMode(AlgSwitchMode mode);
+    void setSineMode(SineMode mode);
+    // Matrix mode replaces the fixed algorithm with the user routing set by setMatrixAlgorithm
+    void setMatrixMode(bool enabled);
+    void setMatrixAlgorithm(const MatrixAlgorithm& matrix);
+    void setEnvelopeCurve(Envelope::Curve curve);
+    void setPolyphony(int numVoices);
+    void setStealPolicy(StealPolicy policy);
+    void setTuning(const TuningTable& tuning);
+    void setNumRenderThreads(int numThreads);
+    // Renders the voices at 1, 2 or 4 times the host rate, or with adaptive on, each voice at the
+    // lowest of those up to factor its bandwidth needs. Sounding notes carry on at the new rate,
+    // reached over a few milliseconds (see advanceOversampling).
+    void setOversampling(int factor, bool adaptive);
+    // Filters every voice with its own lowpass, with key tracking and an envelope, instead of
+    // leaving the filtering to the global filter after the synth
+    void setVoiceFiltering(bool enabled);
+    // Voices whose operators hold still play one cached cycle of their output instead of evaluating them
+    void setCycleCaching(bool enabled);
+    // Stacks numVoices detuned copies of each note, spread across the stereo field; see VoiceHandler::setUnison
+    void setUnison(int numVoices, float detuneCents, float spread);
+    // True when render writes a right channel of its own; otherwise it copies the left
+    bool isStereo() const { return voiceHandler.isStereo(); }
+    void setFilterCutoff(float frequencyHz);
+    void setFilterResonance(float resonance);
+    void setFilterKeyTracking(float amount);
+    void setFilterEnvelopeAmount(float octaves);
+    void updateFilterADSR(float attack, float decay, float sustain, float release);
+    // LFO 1 (index 0) is shared by every voice, LFO 2 (index 1) runs per voice
+    void setLfo(int index, LfoShape shape, float rateHz);
+    void setModulationRoute(int slot, ModSource source, int target, float amount);
+    // Samples between modulation control points, at the host rate
+    void setModulationControlInterval(int samples);
+    // What the routes cost since the last call, per source. Safe to call from any thread.
+    ModulationLoad takeModulationLoad();
+    // True once every voice has finished, release included
+    bool isIdle() const { return voiceHandler.getNumActiveVoices() == 0; }
+    // Ends every parameter ramp on its target, for when rendering resumes after blocks that were skipped
+    void snapParameterRamps();
+    // Delay of the decimation filters at the factor last set, in host-rate samples
+    int getLatencySamples() const { return decimator.getLatency(targetOversampling); }
 private:
     void noteOn(int note, int velocity);
     void noteOff(int note);
-    float sampleRate;
+    float sampleRate = 48000.0f;
+    int oversampling = 1;       // factor of the decimation chain, as a multiple of the host rate
+    int voiceOversampling = 1;  // highest voice rate, at most oversampling
+    int targetOversampling = 1; // factor set by setOversampling, which the two above move to
+    bool adaptiveOversampling = false;
+    static int getRate(int factor) { return factor == 4 ? 2 : factor - 1; }
+    // The parameter ramps run at the highest voice rate; slower voices read every 2nd or 4th value
+    float getVoiceSampleRate() const { return sampleRate * static_cast<float>(oversampling); }
+    // Operator parameters ramp over this long after a change instead of jumping at block boundaries
+    static constexpr double parameterRampSeconds = 0.02;
+    struct OperatorSmoothers
+    {
+        BlockSmoother level;
+        BlockSmoother modIndex;
+        BlockSmoother pitch { BlockSmoother::Curve::Exponential };
+    };
+    std::array<OperatorSmoothers, 6> smoothers;
+    PitchOffsetTable pitchOffsets;
+    static constexpr int numRampBuffers = 6 * 3; // level, modIndex and pitch of each operator
+    static constexpr int numRates = VoiceHandler::numRenderRates;
+    std::vector<float> rampStorage;               // numRampBuffers blocks of rampBufferSize samples per render rate
+    int rampBlockSize = 0;                        // host-rate samples rendered per chunk
+    int rampBufferSize = 0;                       // rampBlockSize at the highest oversampling factor
+    VoiceDecimator decimator;                     // voice sums back to the host rate, once per chunk
+    VoiceDecimator decimatorRight;                // the same for the right channel, while unison is in stereo
+    // The chain being replaced while the oversampling factor changes, and its output
+    VoiceDecimator outgoingDecimator;
+    VoiceDecimator outgoingDecimatorRight;
+    std::vector<float> outgoingOutput;            // rampBlockSize samples per channel
+    int chainFadePosition = -1;                   // host samples into the change of chain, -1 when none runs
+    int lastRatesUsed = 0;                        // render rates the voices used in the last chunk
+    // Host samples a cleared decimation chain needs before its output is whole, and the crossfade after them
+    static constexpr int decimatorSettleSamples = 48;
+    static constexpr double oversamplingFadeSeconds = 0.005;
+    void advanceOversampling();
+    void startChainChange();
+    void crossfadeChains(const std::array<const float*, numRates>& inputs,
+                         const std::array<const float*, numRates>& rightInputs, float* left, float* right, int numSamples);
+    void setVoiceOversampling(int factor);
+    void setRampOversampling(int factor);
+    bool renderedStereo = false;
+    std::vector<float> voiceSums;                 // one voice sum per render rate and channel, rampBufferSize samples each
+    VoiceHandler::RateRamps processRamps(int numSamples);
+    // Folds the routes of the global LFO into the ramps at the highest voice rate, once for all voices
+    void applyGlobalModulation(Voice::Ramps& ramps, int numSamples);
+    ControlRateModulator globalModulation;
+    std::vector<float> modulationStorage;         // one block of rampBufferSize samples per route target
+    // The routes' cost, handed from render to takeModulationLoad
+    void reportModulationCost();
+    std::array<std::atomic<int>, ModMatrix::numSources> reportedRoutes {};
+    std::array<std::atomic<juce::int64>, ModMatrix::numSources> reportedModulationTicks {};
+    std::array<std::atomic<juce::int64>, ModMatrix::numSources> reportedModulationPoints {};
+    float* getRampBuffer(int rate, int buffer) { return rampStorage.data() + size_t((rate * numRampBuffers + buffer) * rampBufferSize); }
     VoiceHandler voiceHandler; //will eventually be a collection of voices. likely a vector
-    //NoiseGenerator noiseGen;
 };
@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    Tuning.cpp
+
+  ==============================================================================
+*/
+
+#include "Tuning.h"
+#include <optional>
+
+namespace
+{
+    // The lines of a Scala file that carry data: "!" starts a comment line
+    juce::StringArray getDataLines(const juce::String& text)
+    {
+        juce::StringArray lines;
+        lines.addLines(text);
+        juce::StringArray data;
+        for (const auto& line : lines)
+            if (!line.startsWithChar('!'))
+                data.add(line);
+        return data;
+    }
+
+    // The first whitespace-separated token of a line; anything after it is a comment
+    juce::String firstToken(const juce::String& line)
+    {
+        return line.trim().upToFirstOccurrenceOf(" ", false, false).upToFirstOccurrenceOf("\t", false, false);
+    }
+
+    // A scale pitch as a frequency ratio: cents when it has a decimal point, otherwise a ratio or whole number
+    bool parsePitch(const juce::String& token, double& ratio)
+    {
+        if (token.isEmpty())
+            return false;
+        if (token.containsChar('.'))
+        {
+            ratio = std::exp2(token.getDoubleValue() / 1200.0);
+            return true;
+        }
+        const auto numerator = token.upToFirstOccurrenceOf("/", false, false).getLargeIntValue();
+        const auto denominator = token.containsChar('/') ? token.fromFirstOccurrenceOf("/", false, false).getLargeIntValue() : 1;
+        if (numerator <= 0 || denominator <= 0)
+            return false;
+        ratio = double(numerator) / double(denominator);
+        return true;
+    }
+}
+
+TuningTable::TuningTable()
+{
+    setEqualTemperament();
+}
+
+void TuningTable::setEqualTemperament()
+{
+    for (int note = 0; note < numNotes; ++note)
+        frequencies[size_t(note)] = static_cast<float>(getEqualTemperedFrequency(note));
+}
+
+juce::Result TuningTable::loadScala(const juce::String& scale, const juce::String& keyboardMapping)
+{
+    // Scale: a description line, the number of pitches, then the pitches. Degree 0 (1/1) is implied
+    // and the last pitch is the period the scale repeats at, usually 2/1.
+    const auto scaleLines = getDataLines(scale);
+    if (scaleLines.size() < 2)
+        return juce::Result::fail("The scale has no pitch count");
+    const int numPitches = firstToken(scaleLines[1]).getIntValue();
+    if (numPitches <= 0 || scaleLines.size() < 2 + numPitches)
+        return juce::Result::fail("The scale has fewer pitches than it declares");
+
+    std::vector<double> degrees { 1.0 };
+    for (int i = 0; i < numPitches; ++i)
+    {
+        double ratio = 1.0;
+        if (!parsePitch(firstToken(scaleLines[2 + i]), ratio))
+            return juce::Result::fail("Invalid pitch: " + scaleLines[2 + i].trim());
+        degrees.push_back(ratio);
+    }
+    const double period = degrees.back();
+    degrees.pop_back();
+
+    // Keyboard mapping: which scale degree each key plays. The default maps every key, middle C
+    // playing degree 0 at its equal-tempered frequency.
+    int mapSize = 0, firstNote = 0, lastNote = numNotes - 1, middleNote = 60, referenceNote = 60;
+    double referenceFrequency = getEqualTemperedFrequency(60);
+    int periodDegree = 0;
+    std::vector<int> mapping;
+    if (keyboardMapping.isNotEmpty())
+    {
+        const auto mapLines = getDataLines(keyboardMapping);
+        if (mapLines.size() < 7)
+            return juce::Result::fail("The keyboard mapping header is incomplete");
+        mapSize = firstToken(mapLines[0]).getIntValue();
+        firstNote = firstToken(mapLines[1]).getIntValue();
+        lastNote = firstToken(mapLines[2]).getIntValue();
+        middleNote = firstToken(mapLines[3]).getIntValue();
+        referenceNote = firstToken(mapLines[4]).getIntValue();
+        referenceFrequency = firstToken(mapLines[5]).getDoubleValue();
+        periodDegree = firstToken(mapLines[6]).getIntValue();
+        if (mapSize < 0 || referenceFrequency <= 0.0)
+            return juce::Result::fail("Invalid keyboard mapping header");
+        for (int i = 0; i < mapSize; ++i)
+        {
+            // Entries missing at the end of the file are unmapped keys
+            const auto token = 7 + i < mapLines.size() ? firstToken(mapLines[7 + i]) : juce::String("x");
+            mapping.push_back(token.equalsIgnoreCase("x") ? -1 : token.getIntValue());
+        }
+    }
+
+    const int numDegrees = int(degrees.size());
+    // Ratio of a scale degree to degree 0, any number of periods up or down
+    auto degreeRatio = [&](int degree)
+    {
+        const int periods = degree >= 0 ? degree / numDegrees : -((numDegrees - 1 - degree) / numDegrees);
+        return degrees[size_t(degree - periods * numDegrees)] * std::pow(period, periods);
+    };
+    // Ratio of a key's pitch to degree 0, or nothing for an unmapped key
+    auto keyRatio = [&](int note) -> std::optional<double>
+    {
+        if (note < firstNote || note > lastNote)
+            return std::nullopt;
+        const int offset = note - middleNote;
+        if (mapSize == 0)
+            return degreeRatio(offset);
+        const int repeats = offset >= 0 ? offset / mapSize : -((mapSize - 1 - offset) / mapSize);
+        const int entry = mapping[size_t(offset - repeats * mapSize)];
+        if (entry < 0)
+            return std::nullopt;
+        // Each repeat of the mapping moves by the interval of periodDegree, or by the scale's period when that is 0
+        const double repeatRatio = periodDegree > 0 ? degreeRatio(periodDegree) : period;
+        return degreeRatio(entry) * std::pow(repeatRatio, repeats);
+    };
+
+    const auto referenceRatio = keyRatio(referenceNote);
+    if (!referenceRatio)
+        return juce::Result::fail("The reference note is not mapped");
+    // Frequency of degree 0, so the reference note sounds at the reference frequency
+    const double baseFrequency = referenceFrequency / *referenceRatio;
+
+    for (int note = 0; note < numNotes; ++note)
+    {
+        const auto ratio = keyRatio(note);
+        const double frequency = ratio ? baseFrequency * *ratio : getEqualTemperedFrequency(note);
+        frequencies[size_t(note)] = static_cast<float>(frequency);
+    }
+    return juce::Result::ok();
+}
+
+PitchOffsetTable::PitchOffsetTable()
+{
+    for (int i = -maxCoarse; i <= maxCoarse; ++i)
+        coarseMultipliers[size_t(i + maxCoarse)] = static_cast<float>(std::exp2(i / 12.0));
+    for (int i = -maxFine; i <= maxFine; ++i)
+        fineMultipliers[size_t(i + maxFine)] = static_cast<float>(std::exp2(i / 1200.0));
+}
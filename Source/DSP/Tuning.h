@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    Tuning.h
+
+    Note frequencies for the synth. TuningTable holds the frequency of every
+    MIDI note, so starting a note is a lookup instead of an exp2. It is
+    rebuilt only when the tuning changes: to 12-tone equal temperament, or
+    from a Scala scale (.scl) and optional keyboard mapping (.kbm) for
+    microtonal work.
+
+    PitchOffsetTable caches the multipliers for the operators' coarse
+    (semitone) and fine (cent) offsets.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+
+class TuningTable
+{
+public:
+    static constexpr int numNotes = 128;
+
+    /// 12-tone equal temperament with A4 (note 69) at 440 Hz
+    TuningTable();
+
+    void setEqualTemperament();
+
+    /*
+    loadScala builds the table from the text of a Scala scale file and, optionally, of a
+    keyboard mapping file. Without a mapping, scale degree 0 sits on middle C (note 60) at
+    its equal-tempered frequency and each key plays the next degree. Keys the mapping leaves
+    out keep their equal-tempered pitch. On an error the table is left unchanged.
+    */
+    juce::Result loadScala(const juce::String& scale, const juce::String& keyboardMapping = {});
+
+    float getFrequency(int note) const { return frequencies[size_t(juce::jlimit(0, numNotes - 1, note))]; }
+
+private:
+    static double getEqualTemperedFrequency(int note) { return 440.0 * std::exp2((note - 69) / 12.0); }
+
+    std::array<float, numNotes> frequencies;
+};
+
+/* PitchOffsetTable maps the operators' coarse and fine offsets to frequency multipliers. */
+class PitchOffsetTable
+{
+public:
+    PitchOffsetTable();
+
+    /// 2^((coarse + fine / 100) / 12). Both are rounded to whole semitones and cents, the parameters' steps.
+    float getMultiplier(float coarseSemitones, float fineCents) const
+    {
+        const int coarse = juce::jlimit(-maxCoarse, maxCoarse, juce::roundToInt(coarseSemitones));
+        const int fine = juce::jlimit(-maxFine, maxFine, juce::roundToInt(fineCents));
+        return coarseMultipliers[size_t(coarse + maxCoarse)] * fineMultipliers[size_t(fine + maxFine)];
+    }
+
+private:
+    static constexpr int maxCoarse = 12; // COARSE_n range
+    static constexpr int maxFine = 100;  // FINE_n range
+    std::array<float, 2 * maxCoarse + 1> coarseMultipliers;
+    std::array<float, 2 * maxFine + 1> fineMultipliers;
+};
@@ -12,11 +12,37 @@
 
 #include "Oscillator.h"
 #include "Operator.h"
-struct Voice {
+#include "AlgSpace.h"
+#include "VoiceFilter.h"
+#include "Modulation.h"
+#include "NoiseGenerator.h"
+#include <numeric>
+#include <utility>
+/*
+Voices live contiguously in VoiceHandler's pool, each one on its own cache line so
+render threads never share one. Voices that run the same algorithm kernel at the
+same rate render side by side in a VoiceBank, their operators gathered into
+[operator][voice] lanes for each run; the rest, with a unison stack, a release
+fade, per-voice routes or the matrix routing, render on their own here.
+*/
+struct alignas(64) Voice {
+    // A render kernel is one algorithm's operator graph, unrolled at compile time. Kernels add to out;
+    // the unison kernels also add to right when it is not null, panning the lanes, see setUnison
+    using RenderKernel = void (Voice::*)(float* out, float* right, int numSamples);
+    using KernelTable = std::array<RenderKernel, AlgSpace::numAlgorithms>;
+    using Ramps = std::array<OperatorRamps, 6>; // parameter ramps of the block, indexed by operator
+    static constexpr int numSineModes = 3;
+    // Longest cached cycle, see renderCycle
+    static constexpr int maxCycleSize = 4096;
+    // Longest lowpass band-limiting a cycle rendered faster than the voice plays it, see startCapture
+    static constexpr int maxCycleFilterTaps = 111;
+    // Memory setCycleBuffer needs: the table, one sample more, then the capture's filter taps and delay line
+    static constexpr int cycleBufferSize = maxCycleSize + 1 + 2 * maxCycleFilterTaps + Operator::maxBlockSize;
+
     void init() {
         for (int i = 0; i < 6; i++)
         {
-            op.emplace_back(i);
+            op[i] = Operator(i);
             op[i].init(i);
         }
 
@@ -32,60 +58,1071 @@ struct Voice {
     
     void reset(float sampleRate) {
         note = -1;
+        fadeSamplesLeft = 0;
         for (int i = 0; i < 6; i++)
         {
 			op[i].reset(sampleRate);
-            op[i].resetCache();
+            op[i].resetFeedback();
         }
+        filter.setSampleRate(sampleRate);
+        filter.reset();
+        filterRight.setSampleRate(sampleRate);
+        filterRight.reset();
+        modulation.setSampleRate(sampleRate, 1);
+        modulation.reset();
+        noise.reset();
+        cycle.playing = false;
+        cycle.baseRate = sampleRate;
+        cycle.oversampling = 1;
+    }
+
+    /// The routing shared by every voice; seed decorrelates this voice's sample-and-hold LFO and noise from the others
+    void setModMatrix(const ModMatrix* matrix, uint32_t seed) {
+        modMatrix = matrix;
+        modulation.seed(seed);
+        noise.seed(seed);
+    }
+
+    /// The user routing the matrix kernel reads, see getMatrixKernel. Owned by VoiceHandler.
+    void setMatrixAlgorithm(const MatrixAlgorithm* matrix) {
+        matrixAlgorithm = matrix;
+        snapMatrixGains();
+    }
+
+    /// Memory for this voice's cached cycle, cycleBufferSize samples, and a voice to render it with, or
+    /// nulls to always render the operators. Both are owned by VoiceHandler.
+    void setCycleBuffer(float* buffer, Voice* capture = nullptr) {
+        jassert(buffer == nullptr || capture != nullptr);
+        cycle.table = buffer;
+        cycle.capture = capture;
+        cycle.playing = false;
+        cycle.captureLength = 0;
     }
 
-    void resetCache() {
+    /// Changes the rate of a sounding voice, e.g. when the oversampling factor changes.
+    /// oversampling is sampleRate as a multiple of the base rate; timbreScale stretches the operators'
+    /// smoothing and feedback delay, see Operator::setSampleRate.
+    void setSampleRate(float sampleRate, int oversampling, float timbreScale) {
+        // A matrix ramp in progress keeps its remaining time
+        if (matrixGains.samplesLeft > 0)
+            startMatrixRamp(juce::jmax(1, juce::roundToInt(float(matrixGains.samplesLeft) * sampleRate / op[0].getSampleRate())));
+        for (auto& o : op)
+            o.setSampleRate(sampleRate, timbreScale);
+        operatorTimbreScale = timbreScale;
+        filter.setSampleRate(sampleRate);
+        filterRight.setSampleRate(sampleRate);
+        modulation.setSampleRate(sampleRate, oversampling);
+        // The cached cycle does not depend on the rate, only its playback speed does
+        cycle.increment = FastSine::frequencyToIncrement(cycle.frequency, sampleRate);
+        cycle.baseRate = sampleRate / float(oversampling);
+        cycle.oversampling = oversampling;
+    }
+
+    /*
+    setAlgorithm switches the voice to a precompiled algorithm and its render kernel.
+    The schedule is owned by AlgSpace and outlives the voice.
+    */
+    void setAlgorithm(const AlgSchedule& newSchedule, RenderKernel newKernel) {
+        schedule = &newSchedule;
+        kernel = newKernel;
         for (int i = 0; i < 6; i++)
         {
-            op[i].resetCache();
+            op[i].setFeedback(i == schedule->feedbackOperator);
+            op[i].resetFeedback();
         }
+        matrixOutputs.fill(0.f);
+        for (auto& lanes : matrixLaneOutputs)
+            lanes.fill(0.f);
+        snapMatrixGains();
     }
-    float render()
-    {
-		float output = 0.f;
-        uint8_t numCarriers = 0;
-        for (int i = 0; i < 6; i++)
-        {
-			if (op[i].isCarrier()) {
-				numCarriers++;
-				output += op[i].getNextSample();
-			}
+
+    /*
+    setUnison stacks numLanes copies of every operator, detuned evenly across
+    +-detuneCents, and spreads them evenly across the stereo field, from
+    -spread (left) to +spread (right) with an equal-power pan law. The lanes
+    are scaled by 1/sqrt(numLanes), so a stack of uncorrelated lanes keeps the
+    loudness of a single voice; at spread 0 both channels carry the mono mix.
+    Only the unison kernels read the lanes, see getUnisonKernels.
+    */
+    void setUnison(int numLanes, float detuneCents, float spread) {
+        const int previousLanes = unison;
+        const bool wasLanes = previousLanes > 1;
+        unison = juce::jlimit(1, Operator::maxUnison, numLanes);
+        // The other kernel takes over: it carries on from the phases and feedback of this one
+        if ((unison > 1) != wasLanes) {
+            for (auto& o : op)
+                o.handOverLanes(unison > 1, juce::jmax(unison, previousLanes));
+            for (size_t j = 0; j < matrixLaneOutputs.size(); j++) {
+                auto& lanes = matrixLaneOutputs[j];
+                if (unison > 1)
+                    lanes.fill(matrixOutputs[j]);
+                else
+                    matrixOutputs[j] = std::accumulate(lanes.begin(), lanes.begin() + previousLanes, 0.f) / float(previousLanes);
+            }
+        }
+        std::array<float, Operator::maxUnison> detune;
+        detune.fill(1.f);
+        laneMono.fill(0.f);
+        laneLeft.fill(0.f);
+        laneRight.fill(0.f);
+        const float gain = 1.f / std::sqrt(float(unison));
+        for (int k = 0; k < unison; k++) {
+            // -1 for the lowest lane, +1 for the highest
+            const float position = unison > 1 ? 2.f * float(k) / float(unison - 1) - 1.f : 0.f;
+            detune[size_t(k)] = std::exp2(position * detuneCents / 1200.f);
+            const float angle = (position * spread + 1.f) * juce::MathConstants<float>::pi * 0.25f;
+            laneMono[size_t(k)] = gain;
+            laneLeft[size_t(k)] = gain * juce::MathConstants<float>::sqrt2 * std::cos(angle);
+            laneRight[size_t(k)] = gain * juce::MathConstants<float>::sqrt2 * std::sin(angle);
+        }
+        maxDetune = unison > 1 ? std::exp2(std::abs(detuneCents) / 1200.f) : 1.f;
+        for (auto& o : op)
+            o.setLaneDetune(detune.data());
+    }
+
+    /// Swaps the render kernel only, e.g. for a different sine engine; operator state is kept
+    void setKernel(RenderKernel newKernel) {
+        kernel = newKernel;
+    }
+
+    /*
+    renderBlock adds numSamples of this voice's output to out using the kernel
+    of the current algorithm. The block is processed in runs of up to
+    Operator::maxBlockSize samples; each run first renders the envelopes of
+    the sounding operators, then runs the kernel over it. right, when not null,
+    receives the right channel of a unison stack and out the left.
+    */
+    void renderBlock(float* out, int numSamples, const Ramps& ramps = {}, float* right = nullptr) {
+        jassert(kernel != nullptr);
+        if (beginBlock(out, numSamples, ramps)) {
+            jassert(right == nullptr); // only unison renders stereo, and a unison stack never repeats
+            return;
+        }
+        for (int start = 0; start < numSamples; start += Operator::maxBlockSize)
+            renderRun(out + start, right != nullptr ? right + start : nullptr,
+                      juce::jmin(Operator::maxBlockSize, numSamples - start), advanced(ramps, start));
+        endBlock();
+    }
+
+    /*
+    The steps of renderBlock, for VoiceBank to render several voices side by side.
+    beginBlock starts the block and, when the voice plays its cached cycle, renders
+    all of it to out and returns true. Otherwise each run of up to
+    Operator::maxBlockSize samples starts with prepareRun, which renders the
+    envelopes of the sounding operators (see getSilentMask) and returns false when
+    no carrier sounds, leaving nothing to render; the bank then steps the operators.
+    endBlock closes the block. Only for voices that canShareLanes.
+    */
+    bool beginBlock(float* out, int numSamples, const Ramps& ramps) {
+        filter.modulationStart = filter.modulationEnd;
+        updateMatrixGains();
+        if (cycle.table != nullptr && updateCycle(ramps, numSamples)) {
+            filter.modulationEnd = 0.f;
+            renderCycle(out, numSamples);
+            return true;
+        }
+        return false;
+    }
+    bool prepareRun(int numSamples, const Ramps& ramps) {
+        jassert(canShareLanes());
+        filter.modulationEnd = 0.f;
+        return prepareOperators(numSamples, ramps);
+    }
+    void endBlock() {
+        filterRight.modulationStart = filter.modulationStart;
+        filterRight.modulationEnd = filter.modulationEnd;
+    }
+    /// Operators skipped for the current run, bit i for operator i
+    uint8_t getSilentMask() const { return silentMask; }
+    /// True when the voice renders like its algorithm kernel alone: one unison lane, no release fade,
+    /// sine operators with phase modulation. The routes of the voice LFO and noise are VoiceHandler's to check
+    bool canShareLanes() const {
+        if (unison > 1 || fadeSamplesLeft > 0)
+            return false;
+        for (const auto& o : op) {
+            if (o.getWaveform() != Waveform::Sine || o.getModulationType() != ModulationType::PM)
+                return false;
         }
-		jassert(numCarriers > 0); // This shouldn't happen
-		return output / float(numCarriers); // average over all carriers
+        return true;
     }
-	void noteOn(int note_, int velocity) {
+
+    /// The same ramps, starting numSamples later
+    static Ramps advanced(const Ramps& ramps, int numSamples) {
+        if (numSamples == 0)
+            return ramps;
+        Ramps result;
+        for (size_t i = 0; i < ramps.size(); i++)
+            result[i] = ramps[i].advancedBy(numSamples);
+        return result;
+    }
+
+    /// 32-entry dispatch table for one sine engine, indexed like AlgSpace::schedules
+    static const KernelTable& getKernels(SineMode mode);
+    /// Kernel of the user matrix routing for one sine engine; the voice must have a MatrixAlgorithm
+    static RenderKernel getMatrixKernel(SineMode mode);
+    /// Unison counterparts of getKernels and getMatrixKernel, for voices with more than one lane
+    static const KernelTable& getUnisonKernels(SineMode mode);
+    static RenderKernel getMatrixUnisonKernel(SineMode mode);
+
+	void noteOn(int note_, int velocity, float frequency) {
+        // The voice LFO restarts with the note; a voice that was silent also drops its old route values
+        if (isActive())
+            modulation.retrigger();
+        else
+        {
+            modulation.reset();
+            filter.modulationStart = filter.modulationEnd = 0.f;
+            matrixOutputs.fill(0.f);
+            for (auto& lanes : matrixLaneOutputs)
+                lanes.fill(0.f);
+            snapMatrixGains();
+        }
 		for (int i = 0; i < 6; i++)
 		{
             note = note_;
 
-			op[i].noteOn(note_, velocity);
+			op[i].noteOn(note_, velocity, frequency);
 		}
+        filter.noteOn(note_);
+        filterRight.noteOn(note_);
 	}
     void noteOff() {
         for (int i = 0; i < 6; i++)
             op[i].noteOff();
+        filter.noteOff();
+        filterRight.noteOff();
+    }
+    /*
+    fastRelease fades the voice's output linearly to zero over numSamples, then stops
+    every operator. Used when a voice is stolen, so the old note ends without a click.
+    */
+    void fastRelease(int numSamples) {
+        jassert(numSamples > 0);
+        if (fadeSamplesLeft > 0 && fadeSamplesLeft <= numSamples)
+            return; // already fading at least as fast
+        fadeStep = 1.f / float(numSamples);
+        fadeGain = fadeSamplesLeft > 0 ? fadeGain : 1.f;
+        fadeSamplesLeft = juce::jmax(1, juce::roundToInt(fadeGain / fadeStep));
+    }
+    bool isFading() const { return fadeSamplesLeft > 0; }
+    int getFadeSamplesLeft() const { return fadeSamplesLeft; }
+    /// Stops all operators at once, without a release
+    void stop() {
+        for (int i = 0; i < 6; i++)
+            op[i].stop();
+        filter.env.reset();
+        filterRight.env.reset();
+        fadeSamplesLeft = 0;
+    }
+    /// Loudest carrier amplitude at the end of the last rendered block, used to find the quietest voice
+    float getLevel() const {
+        float level = 0.f;
+        for (int i = 0; i < 6; i++) {
+            if (schedule->isCarrier(i))
+                level = juce::jmax(level, op[i].getOutputLevel());
+        }
+        return level;
+    }
+    /// Adds what this voice's routes cost since the last call to total, and starts over
+    void takeModulationCost(ModulationCost& total) {
+        total.add(modulationCost);
+        modulationCost.clear();
+    }
+    /*
+    estimateBandwidth bounds the highest frequency in the voice's output over the next
+    block with Carson's rule, applied through the algorithm modulators-first. A modulator
+    reaching fm that deviates an operator at f by a peak phase of beta spreads it up to
+    f + (beta + 1) * fm; feedback counts as the operator modulating itself. Depths use the
+    level ceilings, so an attacking note is judged at full level from its first block.
+    LFO routes are counted at their peaks, and unison at its sharpest lane.
+    */
+    float estimateBandwidth() const {
+        std::array<float, 6> edge{};
+        float bandwidth = 0.f;
+        for (int k = 0; k < 6; k++) {
+            const int i = schedule->order[size_t(k)];
+            const Operator& o = op[size_t(i)];
+            const float frequency = peakFrequency(i);
+            const float index = o.getModulationIndex() + peakModulation(i, ModTarget::modIndex);
+            float top = frequency;
+            for (int m = 0; m < schedule->numMods[size_t(i)]; m++) {
+                const int src = schedule->modSources[size_t(i)][size_t(m)];
+                // A delay edge reads a modulator that comes later in the order: assume it is unmodulated
+                const float srcEdge = juce::jmax(edge[size_t(src)], peakFrequency(src));
+                top += modulationSpread(o, index * peakLevel(src), srcEdge, frequency);
+            }
+            if (o.isFeedback())
+                top += modulationSpread(o, index * 0.25f * peakLevel(i), top, frequency);
+            const float ceiling = peakLevel(i);
+            edge[size_t(i)] = ceiling > 0.f ? top : 0.f;
+            if (schedule->isCarrier(i))
+                bandwidth = juce::jmax(bandwidth, edge[size_t(i)]);
+        }
+        return bandwidth;
     }
     bool isActive() {
-        int sum = 0;
         for (int i = 0; i < 6; i++) {
-            if (op[i].isCarrier())
-                sum += op[i].env.isActive();
+            if (schedule->isCarrier(i) && op[i].env.isActive())
+                return true;
+        }
+        return false;
+    }
+    int note;
+//    int velocity;
+    std::array<Operator, 6> op; // stored inline, so a voice's whole operator state is one contiguous block
+    VoiceFilterState filter;    // used when VoiceHandler filters per voice, see VoiceFilterBank
+    VoiceFilterState filterRight; // the right channel's, while a unison stack is spread in stereo
+private:
+    // Peak phase deviation below which sidebands (under -66 dB) are not counted
+    static constexpr float negligibleDepth = 1e-3f;
+
+    /// Largest control value the LFO routes can give an operator parameter
+    float peakModulation(int i, ModTarget::OperatorParam param) const {
+        const int target = ModTarget::forOperator(i, param);
+        return modMatrix != nullptr ? modMatrix->getPeakValue(target) : ModTarget::restValue(target);
+    }
+    float peakFrequency(int i) const {
+        // Noise already fills the band, and aliased noise is still noise
+        if (op[size_t(i)].getWaveform() == Waveform::Noise)
+            return 0.f;
+        return op[size_t(i)].getBaseFrequency() * peakModulation(i, ModTarget::ratio) * maxDetune;
+    }
+    float peakLevel(int i) const { return op[size_t(i)].getLevelCeiling() * peakModulation(i, ModTarget::level); }
+
+    /*
+    A voice whose operators all hold still, in their sustain with constant parameters,
+    integer ratios and phase modulation, outputs a strictly periodic waveform with the
+    note's period. updateCycle detects that state: the blocks in it render one cycle
+    of the voice into a table (see captureCycle), and from then on renderCycle plays
+    the table with a single phase accumulator while the operators' phases are only
+    advanced. Any movement, a ramp, an LFO route, a release or a changed parameter,
+    falls back to evaluating the operators.
+    */
+    struct CycleCache {
+        float* table = nullptr;  // size + 1 samples, the last repeating the first
+        Voice* capture = nullptr; // the copy rendering the table, see startCapture
+        int size = 0;
+        uint32_t phase = 0;      // fixed point like Oscillator, 0 where the table starts
+        uint32_t increment = 0;
+        float frequency = 0.f;   // the note's fundamental
+        float baseRate = 48000.f;
+        int oversampling = 1;    // the voice's rate as a multiple of baseRate
+        bool playing = false;
+        int captureLength = 0;   // samples the capture renders, 0 when none runs
+        int captured = 0;        // of those, rendered so far
+        int filterHalfLength = 0; // of the capture's lowpass, 0 without one
+        // What the table was rendered from
+        int bandLimit = 1;       // the oversampling it is band-limited for
+        const AlgSchedule* schedule = nullptr;
+        RenderKernel kernel = nullptr;
+        uint32_t matrixRevision = 0;
+        uint8_t silentMask = 0;
+        std::array<float, 6 * 5> parameters{};
+    };
+
+    // Table samples per harmonic of the estimated bandwidth, so linear interpolation stays accurate
+    static constexpr int cycleSamplesPerHarmonic = 12;
+    // Samples rendered before the kept cycle, enough for the feedback smoothing to settle
+    static constexpr int cycleSettleSamples = 64;
+
+    /// True when the operators' output over this block is periodic and the cached cycle holds it
+    bool updateCycle(const Ramps& ramps, int numSamples) {
+        if (!isPeriodic(ramps)) {
+            cycle.playing = false;
+            cycle.captureLength = 0;
+            return false;
         }
-        if (sum > 0) {
+        if (cycle.playing && cycleMatchesOperators())
             return true;
+        cycle.playing = false;
+        if ((cycle.captureLength == 0 || !cycleMatchesOperators()) && !startCapture())
+            return false;
+        // No more of the capture per block than the block itself, at least a run, so it never costs a spike
+        if (captureCycle(juce::jmax(numSamples, Operator::maxBlockSize)))
+            cycle.playing = true; // from the next block: this one is rendered by the operators below
+        // The operators move on from where the table starts while the capture runs
+        cycle.phase += cycle.increment * uint32_t(numSamples);
+        return false;
+    }
+
+    bool isPeriodic(const Ramps& ramps) {
+        // Detuned lanes drift against each other, so a unison stack never repeats
+        if (note < 0 || fadeSamplesLeft > 0 || unison > 1 || matrixGains.samplesLeft > 0)
+            return false;
+        if (modMatrix != nullptr && (!modMatrix->getRoutes(ModSource::VoiceLfo).isEmpty()
+                                     || !modMatrix->getRoutes(ModSource::Noise).isEmpty()))
+            return false;
+        for (const auto& r : ramps) {
+            if (r.level != nullptr || r.modIndex != nullptr || r.pitch != nullptr)
+                return false;
         }
-        else
-        {
+        silentMask = 0;
+        for (int i = 0; i < 6; i++) {
+            const Operator& o = op[size_t(i)];
+            if (o.isSilent()) {
+                silentMask |= uint8_t(1 << i);
+                continue;
+            }
+            // FM integrates the modulation into the phase, so only PM is sure to repeat
+            const float ratio = o.getPitchScale();
+            if (!o.isSteady() || o.getWaveform() == Waveform::Noise || o.getModulationType() != ModulationType::PM
+                || ratio < 0.5f || std::abs(ratio - std::round(ratio)) > 1e-5f)
+                return false;
+        }
+        return (silentMask & schedule->carrierMask) != schedule->carrierMask;
+    }
+
+    std::array<float, 6 * 5> cycleParameters() const {
+        std::array<float, 6 * 5> parameters;
+        for (size_t i = 0; i < 6; i++) {
+            const Operator& o = op[i];
+            parameters[i * 5] = o.getLevel();
+            parameters[i * 5 + 1] = o.getModulationIndex();
+            parameters[i * 5 + 2] = o.getPitchScale();
+            parameters[i * 5 + 3] = o.osc.amplitude;
+            parameters[i * 5 + 4] = o.env.getParameters().sustain;
+        }
+        return parameters;
+    }
+
+    uint32_t matrixRevision() const { return matrixAlgorithm != nullptr ? matrixAlgorithm->revision : 0; }
+
+    bool cycleMatchesOperators() const {
+        return cycle.schedule == schedule && cycle.kernel == kernel && cycle.matrixRevision == matrixRevision()
+            && cycle.silentMask == silentMask && cycle.frequency == op[0].getNoteFrequency()
+            && cycle.bandLimit == cycle.oversampling && cycle.parameters == cycleParameters();
+    }
+
+    /*
+    startCapture sets up the rendering of one period into the table by a copy of the
+    voice (cycle.capture) running at exactly the table size times the note frequency,
+    so each table sample is one sample of the copy. With integer ratios every
+    operator's phase comes back to where it started after a period, so the table
+    starts at the voice's phases as they are now. The capture takes several blocks
+    (see captureCycle), and the voice keeps rendering its operators meanwhile while
+    cycle.phase counts how far they moved on, so playback carries on seamlessly.
+
+    Feedback and delay edges sound different at different rates, so the copy runs as
+    close to the voice's own rate as a whole table size allows, and only as many times
+    faster (up to Operator::maxOversampling) as the estimated bandwidth needs table
+    samples. Played back at the voice's rate, what such a table holds above the
+    voice's Nyquist frequency would alias, so the capture then runs through a
+    windowed-sinc lowpass: flat to 0.7 times that frequency and -70 dB from 1.1 times.
+    A note too low for the largest table keeps rendering its operators.
+    */
+    bool startCapture() {
+        const float frequency = op[0].getNoteFrequency();
+        if (frequency <= 0.f || cycle.capture == nullptr)
+            return false;
+        const float minSize = estimateBandwidth() / frequency * float(cycleSamplesPerHarmonic);
+        int factor = cycle.oversampling;
+        int size = juce::roundToInt(float(factor) * cycle.baseRate / frequency);
+        while (float(size) < minSize && factor < Operator::maxOversampling) {
+            ++factor;
+            size = juce::roundToInt(float(factor) * cycle.baseRate / frequency);
+        }
+        if (size < 2 || size > maxCycleSize)
             return false;
+
+        Voice& capture = *cycle.capture;
+        capture = *this;
+        capture.cycle.table = nullptr;
+        const float captureRate = frequency * float(size);
+        // The copy's feedback lasts as long in time as the voice's
+        capture.setSampleRate(captureRate, factor, operatorTimbreScale * float(factor) / float(cycle.oversampling));
+
+        // The voice's Nyquist frequency in cycles per capture sample
+        const float nyquist = 0.5f * op[0].getSampleRate() / captureRate;
+        cycle.filterHalfLength = 0;
+        if (nyquist < 0.5f) {
+            // Blackman window: the transition band is 5.5 / taps wide, here 0.4 of the voice's Nyquist
+            const int half = juce::jmin(maxCycleFilterTaps / 2, int(std::ceil(5.5f / (0.4f * nyquist) / 2.f)));
+            const float cutoff = 0.9f * nyquist;
+            float* taps = getCycleFilterTaps();
+            float sum = 0.f;
+            for (int i = -half; i <= half; i++) {
+                const float x = juce::MathConstants<float>::pi * float(i);
+                const float sinc = i == 0 ? 2.f * cutoff : std::sin(2.f * cutoff * x) / x;
+                const float window = 0.42f + 0.5f * std::cos(x / float(half)) + 0.08f * std::cos(2.f * x / float(half));
+                taps[i + half] = sinc * window;
+                sum += taps[i + half];
+            }
+            for (int i = 0; i <= 2 * half; i++)
+                taps[i] /= sum;
+            std::fill(getCycleFilterLine(), getCycleFilterLine() + 2 * half, 0.f);
+            cycle.filterHalfLength = half;
         }
+        // The first samples are rendered again a period later, once the feedback and the lowpass have
+        // settled, and overwritten
+        cycle.captureLength = size + cycleSettleSamples + 2 * cycle.filterHalfLength;
+        cycle.captured = 0;
+
+        cycle.bandLimit = cycle.oversampling;
+        cycle.size = size;
+        cycle.phase = 0;
+        cycle.frequency = frequency;
+        cycle.increment = FastSine::frequencyToIncrement(frequency, op[0].getSampleRate());
+        cycle.schedule = schedule;
+        cycle.kernel = kernel;
+        cycle.matrixRevision = matrixRevision();
+        cycle.silentMask = silentMask;
+        cycle.parameters = cycleParameters();
+        return true;
     }
-    int note;
-//    int velocity;
-    std::vector<Operator> op;
+
+    float* getCycleFilterTaps() { return cycle.table + maxCycleSize + 1; }
+    // 2 * filterHalfLength samples of history, then a run
+    float* getCycleFilterLine() { return getCycleFilterTaps() + maxCycleFilterTaps; }
+
+    /// Renders up to budget more samples of the capture into the table; true once the table is complete
+    bool captureCycle(int budget) {
+        Voice& capture = *cycle.capture;
+        const int size = cycle.size;
+        const int half = cycle.filterHalfLength;
+        const float* taps = getCycleFilterTaps();
+        float* line = getCycleFilterLine();
+        std::array<float, Operator::maxBlockSize> run;
+        const int end = juce::jmin(cycle.captureLength, cycle.captured + budget);
+        while (cycle.captured < end) {
+            const int n = juce::jmin(Operator::maxBlockSize, end - cycle.captured);
+            if (half == 0) {
+                std::fill(run.begin(), run.begin() + n, 0.f);
+                capture.renderOperators(run.data(), nullptr, n, {});
+            } else {
+                // One tap at a time across the run, like HalfbandDecimator, so the loops are SIMD
+                float* input = line + 2 * half;
+                std::fill(input, input + n, 0.f);
+                capture.renderOperators(input, nullptr, n, {});
+                juce::FloatVectorOperations::clear(run.data(), n);
+                for (int k = 0; k <= 2 * half; k++)
+                    juce::FloatVectorOperations::addWithMultiply(run.data(), line + k, taps[k], n);
+                std::copy(line + n, line + n + 2 * half, line);
+            }
+            for (int t = 0; t < n; t++) {
+                // The lowpass delays by half its length
+                const int position = cycle.captured + t - half;
+                if (position >= 0)
+                    cycle.table[position % size] = run[size_t(t)];
+            }
+            cycle.captured += n;
+        }
+        if (cycle.captured < cycle.captureLength)
+            return false;
+        cycle.table[size] = cycle.table[0];
+        cycle.captureLength = 0;
+        return true;
+    }
+
+    void renderCycle(float* out, int numSamples) {
+        const uint64_t size = uint64_t(cycle.size);
+        const float* table = cycle.table;
+        uint32_t phase = cycle.phase;
+        for (int t = 0; t < numSamples; t++) {
+            // The phase times the size, in 32.32 fixed point: table index and fraction
+            const uint64_t position = uint64_t(phase) * size;
+            const uint32_t i = uint32_t(position >> 32);
+            const float fraction = float(uint32_t(position)) * FastSine::phaseToCycle;
+            out[t] += table[i] + fraction * (table[i + 1] - table[i]);
+            phase += cycle.increment;
+        }
+        cycle.phase = phase;
+        // Keep the operators in step, so falling back to them continues the waveform
+        for (int i = 0; i < 6; i++) {
+            if ((silentMask >> i) & 1)
+                op[i].skipSamples(numSamples);
+            else
+                op[i].advancePhase(numSamples);
+        }
+    }
+
+    /// Carson's rule for one modulation edge: how far above its own frequency an operator spreads
+    static float modulationSpread(const Operator& o, float depth, float modulatorEdge, float frequency) {
+        if (depth < negligibleDepth)
+            return 0.f;
+        // FM scales the deviation by the operator's frequency, PM by the modulator's
+        const float deviation = depth * (o.getModulationType() == ModulationType::FM ? frequency : modulatorEdge);
+        // Carson's rule keeps ~98% of the power; one more sideband of margin keeps the rest below the noise
+        return deviation + 2.f * modulatorEdge;
+    }
+
+    void renderRun(float* out, float* right, int numSamples, const Ramps& ramps) {
+        const bool lfoRoutes = modMatrix != nullptr && !modMatrix->getRoutes(ModSource::VoiceLfo).isEmpty();
+        const bool noiseRoutes = modMatrix != nullptr && !modMatrix->getRoutes(ModSource::Noise).isEmpty();
+        // One block of noise serves the Noise operators and the Noise routes alike. A unison stack
+        // gets a noise per lane as well: its lanes are mixed at 1 / sqrt(unison), which only keeps
+        // the level when they are uncorrelated
+        bool noiseOperators = false;
+        for (int i = 0; i < 6; i++) {
+            if (op[i].getWaveform() == Waveform::Noise && !op[i].isSilent()) {
+                op[i].setNoiseBlock(noiseBlock.data(), laneNoiseBlock.data());
+                noiseOperators = true;
+            }
+        }
+        if (noiseOperators || noiseRoutes)
+            noise.process(noiseBlock.data(), numSamples);
+        if (noiseOperators && unison > 1)
+            noise.process(laneNoiseBlock.data(), numSamples * Operator::maxUnison);
+
+        if (!lfoRoutes && !noiseRoutes) {
+            filter.modulationEnd = 0.f;
+            renderOperators(out, right, numSamples, ramps);
+            return;
+        }
+        // The routes of this voice's LFO, then those of its noise, each turned into the ramp of the parameter it moves
+        std::array<float, 2 * ModTarget::numTargets * Operator::maxBlockSize> routeBuffers;
+        Ramps result = ramps;
+        float cutoff = 0.f;
+        if (lfoRoutes) {
+            const auto start = juce::Time::getHighResolutionTicks();
+            const auto& routes = modMatrix->getRoutes(ModSource::VoiceLfo);
+            const int numPoints = modulation.process(routes, modMatrix->getLfo(ModSource::VoiceLfo),
+                                                     modMatrix->getControlInterval(), numSamples, routeBuffers.data(),
+                                                     Operator::maxBlockSize);
+            cutoff += modulateRamps(routes, routeBuffers.data(), result, numSamples);
+            modulationCost.add(ModSource::VoiceLfo, start, numPoints);
+        }
+        if (noiseRoutes) {
+            const auto start = juce::Time::getHighResolutionTicks();
+            const auto& routes = modMatrix->getRoutes(ModSource::Noise);
+            float* buffer = routeBuffers.data() + ModTarget::numTargets * Operator::maxBlockSize;
+            for (const auto& route : routes) {
+                juce::FloatVectorOperations::multiply(buffer, noiseBlock.data(), route.depth, numSamples);
+                ModTarget::controlValues(route.target, buffer, numSamples);
+                buffer += Operator::maxBlockSize;
+            }
+            cutoff += modulateRamps(routes, routeBuffers.data() + ModTarget::numTargets * Operator::maxBlockSize,
+                                    result, numSamples);
+            modulationCost.add(ModSource::Noise, start, numSamples); // audio rate: every sample is a control point
+        }
+        filter.modulationEnd = cutoff;
+        renderOperators(out, right, numSamples, result);
+    }
+
+    /// Turns the control values of routes, one maxBlockSize buffer each, into the ramps they move.
+    /// Returns the filter cutoff offset in octaves, which the voice filter takes once per run.
+    float modulateRamps(const ModMatrix::RouteList& routes, float* routeBuffers, Ramps& result, int numSamples) {
+        float cutoff = 0.f;
+        float* buffer = routeBuffers;
+        for (const auto& route : routes) {
+            if (route.target == ModTarget::cutoff)
+                cutoff = buffer[numSamples - 1];
+            else {
+                const int i = route.target / ModTarget::numOperatorParams;
+                auto& r = result[size_t(i)];
+                switch (route.target % ModTarget::numOperatorParams) {
+                    case ModTarget::level:
+                        r.level = ModTarget::applyToRamp(route.target, buffer, r.level, op[i].getLevel(), numSamples);
+                        break;
+                    case ModTarget::ratio:
+                        r.pitch = ModTarget::applyToRamp(route.target, buffer, r.pitch, op[i].getPitchScale(), numSamples);
+                        break;
+                    default:
+                        r.modIndex = ModTarget::applyToRamp(route.target, buffer, r.modIndex, op[i].getModulationIndex(), numSamples);
+                        break;
+                }
+            }
+            buffer += Operator::maxBlockSize;
+        }
+        return cutoff;
+    }
+
+    /// Skips the operators that are silent for the run and renders the envelopes of the others.
+    /// False when no carrier sounds: then every operator has been skipped
+    bool prepareOperators(int numSamples, const Ramps& ramps) {
+        // Operators that are silent for the whole run are skipped as carriers and as modulators
+        silentMask = 0;
+        for (int i = 0; i < 6; i++) {
+            if (op[i].isSilent())
+                silentMask |= uint8_t(1 << i);
+        }
+        if ((silentMask & schedule->carrierMask) == schedule->carrierMask) {
+            if (fadeSamplesLeft > 0) {
+                stop(); // nothing audible left to fade
+                return false;
+            }
+            for (int i = 0; i < 6; i++)
+                op[i].skipSamples(numSamples);
+            return false;
+        }
+        for (int i = 0; i < 6; i++) {
+            if ((silentMask >> i) & 1)
+                op[i].skipSamples(numSamples);
+            else
+                op[i].prepareBlock(numSamples, ramps[size_t(i)]);
+        }
+        return true;
+    }
+
+    void renderOperators(float* out, float* right, int numSamples, const Ramps& ramps) {
+        if (!prepareOperators(numSamples, ramps))
+            return;
+        if (fadeSamplesLeft == 0) {
+            (this->*kernel)(out, right, numSamples);
+            return;
+        }
+        // Fast release: render on the side and ramp the output down, then stop once the fade is done
+        std::array<float, Operator::maxBlockSize> faded, fadedRight;
+        std::fill(faded.begin(), faded.begin() + numSamples, 0.f);
+        if (right != nullptr)
+            std::fill(fadedRight.begin(), fadedRight.begin() + numSamples, 0.f);
+        (this->*kernel)(faded.data(), right != nullptr ? fadedRight.data() : nullptr, numSamples);
+        const int rampLength = juce::jmin(numSamples, fadeSamplesLeft);
+        for (int t = 0; t < rampLength; t++) {
+            fadeGain -= fadeStep;
+            const float gain = juce::jmax(0.f, fadeGain);
+            out[t] += faded[size_t(t)] * gain;
+            if (right != nullptr)
+                right[t] += fadedRight[size_t(t)] * gain;
+        }
+        fadeSamplesLeft -= rampLength;
+        if (fadeSamplesLeft == 0)
+            stop();
+    }
+
+    /*
+    renderKernel evaluates the schedule of one algorithm per sample. Every routing
+    decision is resolved at compile time: the six operators are unrolled in schedule
+    order and each operator's output stays in a local, so modulators are read from
+    registers. Delay edges read the modulator's previous sample.
+    */
+    template <SineMode Mode, int AlgIndex>
+    void renderKernel(float* out, float*, int numSamples) {
+        renderKernel<Mode, AlgIndex>(out, numSamples, std::make_index_sequence<6>{});
+    }
+
+    template <SineMode Mode, int AlgIndex, size_t... K>
+    void renderKernel(float* out, int numSamples, std::index_sequence<K...>) {
+        constexpr const AlgSchedule& s = AlgSpace::schedules[AlgIndex];
+        for (int t = 0; t < numSamples; t++) {
+            std::array<float, 6> y;
+            (processScheduledOperator<Mode, AlgIndex, s.order[K]>(y, t), ...);
+            out[t] += s.carrierGain * (0.f + ... + carrierOutput<AlgIndex, K>(y));
+        }
+    }
+
+    template <SineMode Mode, int AlgIndex, int I>
+    void processScheduledOperator(std::array<float, 6>& y, int t) {
+        constexpr const AlgSchedule& s = AlgSpace::schedules[AlgIndex];
+        if ((silentMask >> I) & 1)
+            y[I] = 0.f;
+        else
+            y[I] = op[I].processSample<Mode>(modulationInput<AlgIndex, I>(y, std::make_index_sequence<s.numMods[I]>{}), t);
+    }
+
+    template <int AlgIndex, int I, size_t... M>
+    float modulationInput(const std::array<float, 6>& y, std::index_sequence<M...>) {
+        return (0.f + ... + modulatorOutput<AlgIndex, I, M>(y));
+    }
+
+    template <int AlgIndex, int I, size_t M>
+    float modulatorOutput(const std::array<float, 6>& y) {
+        constexpr const AlgSchedule& s = AlgSpace::schedules[AlgIndex];
+        constexpr int src = s.modSources[I][M];
+        if constexpr (s.isDelayed(I, int(M)))
+            return op[src].getLastSample();
+        else
+            return y[src];
+    }
+
+    template <int AlgIndex, size_t I>
+    static float carrierOutput(const std::array<float, 6>& y) {
+        if constexpr (AlgSpace::schedules[AlgIndex].isCarrier(int(I)))
+            return y[I];
+        else
+            return 0.f;
+    }
+
+    /*
+    MatrixGains is the user routing as this voice's matrix kernel plays it. An edit
+    ramps in linearly over matrixRampSeconds, like the operator parameters do (see
+    BlockSmoother), so moving a depth or level does not step the sound. The
+    diagonal is held apart as feedback: it scales the operator's smoothed, delayed
+    output by 0.25, as an algorithm's feedback operator does, where the other
+    depths read the raw previous sample.
+    */
+    struct MatrixGains {
+        static constexpr int numOperators = MatrixAlgorithm::numOperators;
+        static constexpr int feedbackRow = numOperators;
+        static constexpr int outputRow = numOperators + 1;
+        using Row = std::array<float, MatrixAlgorithm::lanes>;
+        using Rows = std::array<Row, numOperators + 2>; // depths with a zero diagonal, feedback, output levels
+
+        alignas(32) Rows current{}, target{}, step{};
+        int samplesLeft = 0;
+        uint32_t revision = 0; // of the MatrixAlgorithm target was read from
+    };
+    static constexpr float matrixRampSeconds = 0.02f;
+
+    void readMatrixTarget() {
+        auto& target = matrixGains.target;
+        for (int j = 0; j < MatrixGains::numOperators; j++) {
+            target[size_t(j)] = matrixAlgorithm->depths[size_t(j)];
+            target[size_t(j)][size_t(j)] = 0.f;
+            target[MatrixGains::feedbackRow][size_t(j)] = matrixAlgorithm->depths[size_t(j)][size_t(j)];
+        }
+        target[MatrixGains::outputRow] = matrixAlgorithm->outputLevels;
+        matrixGains.revision = matrixAlgorithm->revision;
+    }
+
+    /// Jumps to the current routing, for a voice that starts playing it
+    void snapMatrixGains() {
+        if (matrixAlgorithm == nullptr)
+            return;
+        readMatrixTarget();
+        matrixGains.current = matrixGains.target;
+        matrixGains.samplesLeft = 0;
+    }
+
+    /// Starts a ramp to an edited routing. Called at the start of each block, so edits land between blocks.
+    void updateMatrixGains() {
+        if (matrixAlgorithm == nullptr || matrixGains.revision == matrixAlgorithm->revision)
+            return;
+        readMatrixTarget();
+        startMatrixRamp(juce::jmax(1, juce::roundToInt(matrixRampSeconds * op[0].getSampleRate())));
+    }
+
+    void startMatrixRamp(int numSamples) {
+        matrixGains.samplesLeft = numSamples;
+        for (size_t r = 0; r < matrixGains.current.size(); r++)
+            for (size_t i = 0; i < size_t(MatrixAlgorithm::lanes); i++)
+                matrixGains.step[r][i] = (matrixGains.target[r][i] - matrixGains.current[r][i]) / float(numSamples);
+    }
+
+    /// One sample of the ramp, landing exactly on the target
+    void advanceMatrixGains() {
+        if (matrixGains.samplesLeft == 0)
+            return;
+        if (--matrixGains.samplesLeft == 0) {
+            matrixGains.current = matrixGains.target;
+            return;
+        }
+        for (size_t r = 0; r < matrixGains.current.size(); r++)
+            for (size_t i = 0; i < size_t(MatrixAlgorithm::lanes); i++)
+                matrixGains.current[r][i] += matrixGains.step[r][i];
+    }
+
+    /*
+    renderMatrixKernel evaluates a MatrixAlgorithm. All edges read the previous
+    sample, so each sample first computes every operator's modulation input at
+    once: a sum of depth columns weighted by last sample's outputs, eight lanes
+    wide, plus the diagonal's feedback. Operator feedback is off; the matrix
+    diagonal replaces it.
+    */
+    template <SineMode Mode>
+    void renderMatrixKernel(float* out, float*, int numSamples) {
+        constexpr int lanes = MatrixAlgorithm::lanes;
+        const auto& gains = matrixGains.current;
+        alignas(32) std::array<float, lanes> y = matrixOutputs;
+        for (int t = 0; t < numSamples; t++) {
+            alignas(32) std::array<float, lanes> input{};
+            for (int j = 0; j < MatrixAlgorithm::numOperators; j++) {
+                const float source = y[size_t(j)];
+                for (int i = 0; i < lanes; i++)
+                    input[size_t(i)] += gains[size_t(j)][size_t(i)] * source;
+            }
+            for (int i = 0; i < MatrixAlgorithm::numOperators; i++) {
+                const float feedback = gains[MatrixGains::feedbackRow][size_t(i)] * 0.25f * op[size_t(i)].getFeedbackSample();
+                y[size_t(i)] = ((silentMask >> i) & 1) ? 0.f : op[size_t(i)].processSample<Mode>(input[size_t(i)] + feedback, t);
+            }
+            float sum = 0.f;
+            for (int i = 0; i < lanes; i++)
+                sum += gains[MatrixGains::outputRow][size_t(i)] * y[size_t(i)];
+            out[t] += sum;
+            advanceMatrixGains();
+        }
+        matrixOutputs = y;
+    }
+
+    /*
+    The unison kernels run the same graphs with every value widened to the
+    voice's lanes: lane k of an operator is modulated by lane k of its
+    modulators only, so each lane is a complete detuned copy of the voice.
+    Every loop runs over all Operator::maxUnison lanes, a fixed trip count the
+    compiler turns into SIMD operations; lanes beyond the voice's unison have
+    zero mix gains, so they cost one register's width and are never heard.
+    */
+    using Lanes = std::array<float, Operator::maxUnison>;
+
+    template <SineMode Mode, int AlgIndex>
+    void renderUnisonKernel(float* out, float* right, int numSamples) {
+        renderUnisonKernel<Mode, AlgIndex>(out, right, numSamples, std::make_index_sequence<6>{});
+    }
+
+    template <SineMode Mode, int AlgIndex, size_t... K>
+    void renderUnisonKernel(float* out, float* right, int numSamples, std::index_sequence<K...>) {
+        constexpr const AlgSchedule& s = AlgSpace::schedules[AlgIndex];
+        for (int t = 0; t < numSamples; t++) {
+            alignas(32) std::array<Lanes, 6> y;
+            (processScheduledLanes<Mode, AlgIndex, s.order[K]>(y, t), ...);
+            alignas(32) Lanes sum{};
+            (addCarrierLanes<AlgIndex, K>(sum, y), ...);
+            mixLanes(sum, s.carrierGain, out, right, t);
+        }
+    }
+
+    template <SineMode Mode, int AlgIndex, int I>
+    void processScheduledLanes(std::array<Lanes, 6>& y, int t) {
+        constexpr const AlgSchedule& s = AlgSpace::schedules[AlgIndex];
+        if ((silentMask >> I) & 1) {
+            y[I].fill(0.f);
+            return;
+        }
+        alignas(32) Lanes input{};
+        addModulatorLanes<AlgIndex, I>(input, y, std::make_index_sequence<s.numMods[I]>{});
+        op[I].processLanes<Mode>(input.data(), y[I].data(), unison, t);
+    }
+
+    template <int AlgIndex, int I, size_t... M>
+    void addModulatorLanes(Lanes& input, const std::array<Lanes, 6>& y, std::index_sequence<M...>) {
+        (addLanes(input, modulatorLanes<AlgIndex, I, M>(y)), ...);
+    }
+
+    template <int AlgIndex, int I, size_t M>
+    const float* modulatorLanes(const std::array<Lanes, 6>& y) {
+        constexpr const AlgSchedule& s = AlgSpace::schedules[AlgIndex];
+        constexpr int src = s.modSources[I][M];
+        if constexpr (s.isDelayed(I, int(M)))
+            return op[src].getLastLaneSamples();
+        else
+            return y[src].data();
+    }
+
+    template <int AlgIndex, size_t I>
+    void addCarrierLanes(Lanes& sum, const std::array<Lanes, 6>& y) {
+        if constexpr (AlgSpace::schedules[AlgIndex].isCarrier(int(I)))
+            addLanes(sum, y[I].data());
+    }
+
+    static void addLanes(Lanes& sum, const float* lanes) {
+        for (size_t k = 0; k < sum.size(); k++)
+            sum[k] += lanes[k];
+    }
+
+    /// Pans the summed lanes of one sample into out and right, or mixes them into out alone
+    void mixLanes(const Lanes& sum, float gain, float* out, float* right, int t) const {
+        if (right == nullptr) {
+            float mono = 0.f;
+            for (size_t k = 0; k < sum.size(); k++)
+                mono += laneMono[k] * sum[k];
+            out[t] += gain * mono;
+            return;
+        }
+        float left = 0.f, rightSum = 0.f;
+        for (size_t k = 0; k < sum.size(); k++) {
+            left += laneLeft[k] * sum[k];
+            rightSum += laneRight[k] * sum[k];
+        }
+        out[t] += gain * left;
+        right[t] += gain * rightSum;
+    }
+
+    template <SineMode Mode>
+    void renderMatrixUnisonKernel(float* out, float* right, int numSamples) {
+        const auto& gains = matrixGains.current;
+        constexpr int numOps = MatrixAlgorithm::numOperators;
+        for (int t = 0; t < numSamples; t++) {
+            alignas(32) std::array<Lanes, numOps> input{};
+            for (int j = 0; j < numOps; j++) {
+                for (int i = 0; i < numOps; i++) {
+                    const float depth = gains[size_t(j)][size_t(i)];
+                    for (size_t k = 0; k < size_t(Operator::maxUnison); k++)
+                        input[size_t(i)][k] += depth * matrixLaneOutputs[size_t(j)][k];
+                }
+            }
+            for (int i = 0; i < numOps; i++) {
+                const float feedback = gains[MatrixGains::feedbackRow][size_t(i)] * 0.25f;
+                const float* history = op[size_t(i)].getLaneFeedbackSamples();
+                for (size_t k = 0; k < size_t(Operator::maxUnison); k++)
+                    input[size_t(i)][k] += feedback * history[k];
+            }
+            alignas(32) Lanes sum{};
+            for (int i = 0; i < numOps; i++) {
+                auto& y = matrixLaneOutputs[size_t(i)];
+                if ((silentMask >> i) & 1)
+                    y.fill(0.f);
+                else
+                    op[size_t(i)].processLanes<Mode>(input[size_t(i)].data(), y.data(), unison, t);
+                for (size_t k = 0; k < sum.size(); k++)
+                    sum[k] += gains[MatrixGains::outputRow][size_t(i)] * y[k];
+            }
+            mixLanes(sum, 1.f, out, right, t);
+            advanceMatrixGains();
+        }
+    }
+
+    template <SineMode Mode, size_t... A>
+    static constexpr KernelTable makeKernelTable(std::index_sequence<A...>) {
+        return { &Voice::renderKernel<Mode, int(A)>... };
+    }
+
+    template <SineMode Mode, size_t... A>
+    static constexpr KernelTable makeUnisonKernelTable(std::index_sequence<A...>) {
+        return { &Voice::renderUnisonKernel<Mode, int(A)>... };
+    }
+
+    const AlgSchedule* schedule = nullptr;
+    RenderKernel kernel = nullptr;
+    const ModMatrix* modMatrix = nullptr;
+    const MatrixAlgorithm* matrixAlgorithm = nullptr;
+    alignas(32) std::array<float, MatrixAlgorithm::lanes> matrixOutputs{}; // last sample of each operator, for the matrix kernel
+    alignas(32) std::array<Lanes, MatrixAlgorithm::numOperators> matrixLaneOutputs{}; // the same per lane, for the unison matrix kernel
+    MatrixGains matrixGains; // the routing the matrix kernels play, see MatrixGains
+    // Unison lanes and their mix gains, see setUnison
+    int unison = 1;
+    float maxDetune = 1.f;
+    alignas(32) Lanes laneMono{}, laneLeft{}, laneRight{};
+    ControlRateModulator modulation; // this voice's LFO and the values of its routes
+    ModulationCost modulationCost; // what the routes above cost since the voice handler last took it
+    NoiseGenerator noise; // the Noise waveform and modulation source, seeded per voice
+    alignas(32) std::array<float, Operator::maxBlockSize> noiseBlock{}; // noise of the current run
+    alignas(32) std::array<float, Operator::maxBlockSize * Operator::maxUnison> laneNoiseBlock{}; // the same per unison lane, sample by sample
+    CycleCache cycle;
+    uint8_t silentMask = 0; // bit i set: operator i is skipped for the current block
+    int fadeSamplesLeft = 0; // > 0 while a fast release is running
+    float fadeGain = 1.f, fadeStep = 0.f;
+    float operatorTimbreScale = 1.f; // see setSampleRate
 };
+
+inline const Voice::KernelTable& Voice::getKernels(SineMode mode)
+{
+    // indexed by SineMode
+    static constexpr std::array<KernelTable, numSineModes> kernels = {
+        makeKernelTable<SineMode::Exact>(std::make_index_sequence<AlgSpace::numAlgorithms>{}),
+        makeKernelTable<SineMode::Table>(std::make_index_sequence<AlgSpace::numAlgorithms>{}),
+        makeKernelTable<SineMode::Polynomial>(std::make_index_sequence<AlgSpace::numAlgorithms>{})
+    };
+    return kernels[static_cast<int>(mode)];
+}
+
+inline Voice::RenderKernel Voice::getMatrixKernel(SineMode mode)
+{
+    // indexed by SineMode
+    static constexpr std::array<RenderKernel, numSineModes> kernels = {
+        &Voice::renderMatrixKernel<SineMode::Exact>,
+        &Voice::renderMatrixKernel<SineMode::Table>,
+        &Voice::renderMatrixKernel<SineMode::Polynomial>
+    };
+    return kernels[static_cast<int>(mode)];
+}
+
+inline const Voice::KernelTable& Voice::getUnisonKernels(SineMode mode)
+{
+    // indexed by SineMode
+    static constexpr std::array<KernelTable, numSineModes> kernels = {
+        makeUnisonKernelTable<SineMode::Exact>(std::make_index_sequence<AlgSpace::numAlgorithms>{}),
+        makeUnisonKernelTable<SineMode::Table>(std::make_index_sequence<AlgSpace::numAlgorithms>{}),
+        makeUnisonKernelTable<SineMode::Polynomial>(std::make_index_sequence<AlgSpace::numAlgorithms>{})
+    };
+    return kernels[static_cast<int>(mode)];
+}
+
+inline Voice::RenderKernel Voice::getMatrixUnisonKernel(SineMode mode)
+{
+    // indexed by SineMode
+    static constexpr std::array<RenderKernel, numSineModes> kernels = {
+        &Voice::renderMatrixUnisonKernel<SineMode::Exact>,
+        &Voice::renderMatrixUnisonKernel<SineMode::Table>,
+        &Voice::renderMatrixUnisonKernel<SineMode::Polynomial>
+    };
+    return kernels[static_cast<int>(mode)];
+}
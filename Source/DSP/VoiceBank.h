@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    VoiceBank.h
+
+    Renders up to eight voices that play the same algorithm at the same rate
+    side by side. For each run every operator of those voices is gathered into
+    [operator][voice] lanes (OperatorLanes), the algorithm's schedule steps
+    across all of them, one operator step per bank in SIMD registers instead
+    of one per voice, and the state goes back to the voices after the run.
+
+    The lane kernel evaluates the same expressions in the same order as
+    Voice::renderKernel, so each voice renders exactly what it would alone.
+    A voice playing its cached cycle sits the block out of the lanes.
+    VoiceHandler picks the voices, see Voice::canShareLanes.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "Voice.h"
+
+class VoiceBank
+{
+public:
+    static constexpr int lanes = OperatorLanes::width;
+    /// The bank steps all its lanes whatever it holds: fewer voices than this render faster one by one
+    static constexpr int minVoices = lanes / 2 + 1;
+
+    /// Adds numSamples of each voice's output to its buffer in outputs. The voices run algorithm,
+    /// an index into AlgSpace::schedules, on the kernels of mode, all at one rate with the same ramps
+    void renderBlock(Voice* const* voices, float* const* outputs, int numVoices, int numSamples,
+                     const Voice::Ramps& ramps, SineMode mode, int algorithm);
+
+private:
+    using Floats = OperatorLanes::Floats;
+    using LaneKernel = void (VoiceBank::*)(int numSamples);
+    using KernelTable = std::array<LaneKernel, AlgSpace::numAlgorithms>;
+
+    // Uninitialised: every run writes what it reads
+    std::array<OperatorLanes, 6> ops;
+    alignas(32) std::array<Floats, Operator::maxBlockSize> output; // the voices' sum of carriers, per sample
+    uint8_t silentMask = 0; // bit i set: operator i is silent in every lane for the run
+
+    static const KernelTable& getKernels(SineMode mode);
+
+    template <SineMode Mode, int AlgIndex>
+    void renderKernel(int numSamples) {
+        renderKernel<Mode, AlgIndex>(numSamples, std::make_index_sequence<6>{});
+    }
+
+    template <SineMode Mode, int AlgIndex, size_t... K>
+    void renderKernel(int numSamples, std::index_sequence<K...>) {
+        constexpr const AlgSchedule& s = AlgSpace::schedules[AlgIndex];
+        for (int t = 0; t < numSamples; t++) {
+            alignas(32) std::array<Floats, 6> y;
+            (processScheduledOperator<Mode, AlgIndex, s.order[K]>(y, t), ...);
+            auto& sum = output[size_t(t)];
+            for (size_t k = 0; k < size_t(lanes); k++)
+                sum[k] = s.carrierGain * (0.f + ... + carrierOutput<AlgIndex, K>(y, k));
+        }
+    }
+
+    template <SineMode Mode, int AlgIndex, int I>
+    void processScheduledOperator(std::array<Floats, 6>& y, int t) {
+        constexpr const AlgSchedule& s = AlgSpace::schedules[AlgIndex];
+        if ((silentMask >> I) & 1) {
+            y[I].fill(0.f);
+            return;
+        }
+        alignas(32) Floats input;
+        for (size_t k = 0; k < size_t(lanes); k++)
+            input[k] = modulationInput<AlgIndex, I>(y, k, std::make_index_sequence<s.numMods[I]>{});
+        ops[I].process<Mode>(input, y[I], t);
+    }
+
+    template <int AlgIndex, int I, size_t... M>
+    float modulationInput(const std::array<Floats, 6>& y, size_t k, std::index_sequence<M...>) const {
+        juce::ignoreUnused(k); // by operators without modulators
+        return (0.f + ... + modulatorOutput<AlgIndex, I, M>(y, k));
+    }
+
+    template <int AlgIndex, int I, size_t M>
+    float modulatorOutput(const std::array<Floats, 6>& y, size_t k) const {
+        constexpr const AlgSchedule& s = AlgSpace::schedules[AlgIndex];
+        constexpr int src = s.modSources[I][M];
+        if constexpr (s.isDelayed(I, int(M)))
+            return ops[src].lastSample[k];
+        else
+            return y[src][k];
+    }
+
+    template <int AlgIndex, size_t I>
+    static float carrierOutput(const std::array<Floats, 6>& y, size_t k) {
+        if constexpr (AlgSpace::schedules[AlgIndex].isCarrier(int(I)))
+            return y[I][k];
+        else
+            return 0.f;
+    }
+
+    template <SineMode Mode, size_t... A>
+    static constexpr KernelTable makeKernelTable(std::index_sequence<A...>) {
+        return { &VoiceBank::renderKernel<Mode, int(A)>... };
+    }
+};
+
+inline void VoiceBank::renderBlock(Voice* const* voices, float* const* outputs, int numVoices, int numSamples,
+                                   const Voice::Ramps& ramps, SineMode mode, int algorithm)
+{
+    jassert(numVoices > 0 && numVoices <= lanes);
+    const LaneKernel kernel = getKernels(mode)[size_t(algorithm)];
+    // Voices playing their cached cycle have rendered the whole block here
+    std::array<bool, lanes> running{};
+    for (int k = 0; k < numVoices; k++)
+        running[size_t(k)] = !voices[k]->beginBlock(outputs[k], numSamples, ramps);
+
+    for (int start = 0; start < numSamples; start += Operator::maxBlockSize) {
+        const int n = juce::jmin(Operator::maxBlockSize, numSamples - start);
+        const Voice::Ramps runRamps = Voice::advanced(ramps, start);
+        std::array<bool, lanes> sounding{};
+        bool anySounding = false;
+        for (int k = 0; k < numVoices; k++) {
+            sounding[size_t(k)] = running[size_t(k)] && voices[k]->prepareRun(n, runRamps);
+            anySounding = anySounding || sounding[size_t(k)];
+        }
+        if (!anySounding)
+            continue;
+
+        silentMask = 0;
+        for (size_t i = 0; i < ops.size(); i++) {
+            auto& lanesOfOp = ops[i];
+            voices[0]->op[i].copySettingsToLanes(lanesOfOp);
+            lanesOfOp.modIndexRamp = runRamps[i].modIndex;
+            lanesOfOp.pitchRamp = runRamps[i].pitch;
+            bool anyLane = false;
+            for (int k = 0; k < lanes; k++) {
+                if (k < numVoices && sounding[size_t(k)] && !((voices[k]->getSilentMask() >> i) & 1)) {
+                    voices[k]->op[i].copyToLane(lanesOfOp, k, n);
+                    anyLane = true;
+                }
+                else
+                    lanesOfOp.silenceLane(k, n);
+            }
+            if (!anyLane)
+                silentMask |= uint8_t(1 << i);
+        }
+
+        (this->*kernel)(n);
+
+        for (int k = 0; k < numVoices; k++) {
+            if (!sounding[size_t(k)])
+                continue;
+            for (size_t i = 0; i < ops.size(); i++) {
+                if (!((voices[k]->getSilentMask() >> i) & 1))
+                    voices[k]->op[i].copyFromLane(ops[i], k, n);
+            }
+            float* out = outputs[k] + start;
+            for (int t = 0; t < n; t++)
+                out[t] += output[size_t(t)][size_t(k)];
+        }
+    }
+
+    for (int k = 0; k < numVoices; k++) {
+        if (running[size_t(k)])
+            voices[k]->endBlock();
+    }
+}
+
+inline const VoiceBank::KernelTable& VoiceBank::getKernels(SineMode mode)
+{
+    // indexed by SineMode
+    static constexpr std::array<KernelTable, Voice::numSineModes> kernels = {
+        makeKernelTable<SineMode::Exact>(std::make_index_sequence<AlgSpace::numAlgorithms>{}),
+        makeKernelTable<SineMode::Table>(std::make_index_sequence<AlgSpace::numAlgorithms>{}),
+        makeKernelTable<SineMode::Polynomial>(std::make_index_sequence<AlgSpace::numAlgorithms>{})
+    };
+    return kernels[static_cast<int>(mode)];
+}
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    VoiceFilter.cpp
+
+  ==============================================================================
+*/
+
+#include "VoiceFilter.h"
+
+void VoiceFilterBank::process(VoiceFilterState* const* states, float* const* buffers, int numLanes, int numSamples, float sampleRate)
+{
+    jassert(numLanes > 0 && numLanes <= lanes);
+    if (numSamples <= 0)
+        return;
+
+    // Per-lane constants and states. Unused lanes filter silence and are never written back.
+    const float inverseRate = 1.f / sampleRate;
+    alignas(32) std::array<float, lanes> keyOctaves{}, modulationSteps{}, s1{}, s2{};
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        const auto& state = *states[lane];
+        keyOctaves[size_t(lane)] = keyTracking * static_cast<float>(state.note - 60) / 12.f + state.modulationStart;
+        modulationSteps[size_t(lane)] = (state.modulationEnd - state.modulationStart) / static_cast<float>(numSamples);
+        s1[size_t(lane)] = state.s1;
+        s2[size_t(lane)] = state.s2;
+    }
+
+    const float octaveStep = (endOctaves - startOctaves) / static_cast<float>(numSamples);
+    const float dampingStep = (endDamping - startDamping) / static_cast<float>(numSamples);
+
+    // Sample-major scratch: the lanes of one sample are adjacent, so the inner loop is one register op per step
+    alignas(32) std::array<float, chunkSize * lanes> signal{}, envelope{};
+    std::array<float, chunkSize> laneScratch;
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const int length = juce::jmin(chunkSize, numSamples - start);
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            const float* input = buffers[lane] + start;
+            states[lane]->env.renderBlock(laneScratch.data(), length);
+            for (int t = 0; t < length; ++t)
+            {
+                signal[size_t(t * lanes + lane)] = input[t];
+                envelope[size_t(t * lanes + lane)] = laneScratch[size_t(t)];
+            }
+        }
+
+        for (int t = 0; t < length; ++t)
+        {
+            const float position = static_cast<float>(start + t + 1);
+            const float baseOctaves = startOctaves + octaveStep * position;
+            const float damping = startDamping + dampingStep * position;
+            float* x = signal.data() + t * lanes;
+            const float* env = envelope.data() + t * lanes;
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                const float octaves = baseOctaves + keyOctaves[size_t(lane)] + modulationSteps[size_t(lane)] * position
+                                    + envelopeOctaves * env[lane];
+                const float cutoff = FilterMath::clampPositive(FilterMath::exp2(octaves) * inverseRate,
+                                                               minNormalisedCutoff, maxNormalisedCutoff);
+                const float g = FilterMath::tanPi(cutoff);
+                const float h = 1.f / (1.f + g * (g + damping));
+                const float highpass = h * (x[lane] - s1[size_t(lane)] * (g + damping) - s2[size_t(lane)]);
+                const float bandpass = highpass * g + s1[size_t(lane)];
+                s1[size_t(lane)] = highpass * g + bandpass;
+                const float lowpass = bandpass * g + s2[size_t(lane)];
+                s2[size_t(lane)] = bandpass * g + lowpass;
+                x[lane] = lowpass;
+            }
+        }
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            float* output = buffers[lane] + start;
+            for (int t = 0; t < length; ++t)
+                output[t] = signal[size_t(t * lanes + lane)];
+        }
+    }
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        // Same threshold as juce::dsp::util::snapToZero, so decayed states do not go denormal
+        states[lane]->s1 = std::abs(s1[size_t(lane)]) < 1.0e-8f ? 0.f : s1[size_t(lane)];
+        states[lane]->s2 = std::abs(s2[size_t(lane)]) < 1.0e-8f ? 0.f : s2[size_t(lane)];
+    }
+}
@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    VoiceFilter.h
+
+    Per-voice lowpass filtering. Every voice carries the state of a TPT
+    state-variable filter (the topology of juce::dsp::StateVariableTPTFilter)
+    and its own filter envelope; VoiceFilterBank runs the filters of up to
+    eight voices side by side, one voice per SIMD lane.
+
+    The cutoff may move every sample (envelope, key tracking, parameter
+    ramps), so the coefficient g = tan(pi * fc / fs) is recomputed per sample
+    and lane. exp2 and tan use branch-free approximations the compiler can
+    vectorise across the lanes.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "Envelope.h"
+#include "FastSine.h"
+
+namespace FilterMath
+{
+    // 2^x ~= e0 + e1 x + ... + e4 x^4 for x in [0, 1): Chebyshev fit, relative error 3.5e-6 (0.006 cents)
+    constexpr float e0 = 1.000003457e+00f;
+    constexpr float e1 = 6.929728985e-01f;
+    constexpr float e2 = 2.416043580e-01f;
+    constexpr float e3 = 5.174499750e-02f;
+    constexpr float e4 = 1.367030945e-02f;
+
+    // 2^x for -126 < x < 126: the polynomial on the fraction, scaled by the integer part through the
+    // exponent bits. The floor is a truncation of x + 128, which needs no rounding-mode instructions.
+    inline float exp2(float x)
+    {
+        const int32_t whole = int32_t(x + 128.f) - 128;
+        const float f = x - float(whole);
+        const float p = e0 + f * (e1 + f * (e2 + f * (e3 + f * e4)));
+        const int32_t bits = (whole + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return p * scale;
+    }
+
+    // Clamps a positive x to [lo, hi] on the bit patterns, which order like the values for positive floats.
+    // Integer compares let the compiler vectorise the clamp; float compares may trap, so they stay branches.
+    inline float clampPositive(float x, float lo, float hi)
+    {
+        int32_t bits, lowBits, highBits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        std::memcpy(&lowBits, &lo, sizeof(lowBits));
+        std::memcpy(&highBits, &hi, sizeof(highBits));
+        bits = bits < lowBits ? lowBits : bits;
+        bits = bits > highBits ? highBits : bits;
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    // tan(pi x) for x in [0, 0.5): sin over cos, both on FastSine's quarter-cycle polynomial.
+    // The relative error stays below 2e-5 up to x = 0.49, where cos is smallest.
+    inline float tanPi(float x)
+    {
+        const float half = 0.5f * x;
+        return FastSine::polynomial(half) / FastSine::polynomial(0.25f - half);
+    }
+}
+
+/*
+VoiceFilterState is the part of a voice filter that belongs to the voice: the
+integrator states, the filter envelope and the note for key tracking. It lives
+in Voice, so it is copied and moves between render rates with the voice.
+*/
+struct VoiceFilterState
+{
+    float s1 = 0.f, s2 = 0.f;
+    int note = 60;
+    // Cutoff offset from the voice's LFO routes, in octaves, gliding from start to end over a block
+    float modulationStart = 0.f, modulationEnd = 0.f;
+    Envelope env;
+
+    void setSampleRate(float sampleRate) { env.setSampleRate(sampleRate); }
+    void reset() { s1 = s2 = 0.f; modulationStart = modulationEnd = 0.f; env.reset(); }
+    // The states carry on, so a retriggered or stolen voice does not click
+    void noteOn(int note_) { note = note_; env.noteOn(); }
+    void noteOff() { env.noteOff(); }
+};
+
+/*
+VoiceFilterBank holds the filter settings shared by every voice and filters
+voice blocks in groups of up to `lanes`. Cutoff and resonance changes glide
+linearly over one rendered block; in octaves for the cutoff.
+*/
+class VoiceFilterBank
+{
+public:
+    /// Voices filtered per pass: two SSE/NEON registers or one AVX register
+    static constexpr int lanes = 8;
+
+    void setCutoff(float frequencyHz) { targetOctaves = std::log2(juce::jmax(1.f, frequencyHz)); }
+    /// Same scale as juce::dsp::StateVariableTPTFilter: 1/sqrt(2) is flat, higher values peak
+    void setResonance(float resonance) { targetDamping = 1.f / juce::jmax(0.01f, resonance); }
+    /// 0: the cutoff ignores the note. 1: it follows the keyboard, an octave per octave from middle C.
+    void setKeyTracking(float amount) { keyTracking = amount; }
+    /// Cutoff offset at full filter envelope, in octaves
+    void setEnvelopeAmount(float octaves) { envelopeOctaves = octaves; }
+    /// Cutoff offset shared by every voice, in octaves, from the global LFO's routes
+    void setModulation(float octaves) { modulationOctaves = octaves; }
+
+    /// Jumps to the latest settings, e.g. after prepare
+    void snapToTargets()
+    {
+        startOctaves = endOctaves = targetOctaves + modulationOctaves;
+        startDamping = endDamping = targetDamping;
+    }
+
+    /// Starts the glide to the latest settings. Call once per rendered block, before process.
+    void beginBlock()
+    {
+        startOctaves = endOctaves;
+        startDamping = endDamping;
+        endOctaves = targetOctaves + modulationOctaves;
+        endDamping = targetDamping;
+    }
+
+    /*
+    process filters numLanes voice blocks in place, all numSamples long at sampleRate.
+    The blocks cover the whole block begun by beginBlock, so a voice at a higher render
+    rate sees the same glide in more samples. Each state's envelope advances numSamples,
+    and its own cutoff modulation glides from modulationStart to modulationEnd.
+    */
+    void process(VoiceFilterState* const* states, float* const* buffers, int numLanes, int numSamples, float sampleRate);
+
+private:
+    static constexpr int chunkSize = 64;           // samples per lane held in the interleaved scratch
+    static constexpr float maxNormalisedCutoff = 0.49f;
+    static constexpr float minNormalisedCutoff = 1e-5f;
+
+    float targetOctaves = std::log2(20000.f), startOctaves = targetOctaves, endOctaves = targetOctaves;
+    float targetDamping = 1.41421356f, startDamping = targetDamping, endDamping = targetDamping;
+    float keyTracking = 0.f;
+    float envelopeOctaves = 0.f;
+    float modulationOctaves = 0.f;
+};
@@ -12,155 +12,1128 @@
 #pragma once
 
 #include "Voice.h"    // Ensure your voice.h defines the Voice class interface.
+#include "VoiceBank.h"
 #include <vector>
-#include <map>
+#include <array>
 #include <algorithm>
 #include "AlgSpace.h"
+#include "VoiceWorkerPool.h"
+#include "Tuning.h"
+
+/// Which sounding voice gives way when a note arrives and every voice is busy.
+enum class StealPolicy
+{
+    Oldest,        // the voice whose note started first
+    Quietest,      // the voice with the lowest carrier level
+    ReleasedFirst, // the longest-released voice, else the oldest
+    SameNote       // like ReleasedFirst, but a note that is still releasing reuses its own voice
+};
+
+/// What sounding voices do when the algorithm changes. Voices that are not sounding always switch at once.
+enum class AlgSwitchMode
+{
+    Instant,   // every voice switches on the next sample
+    NewNotes,  // sounding notes keep their routing; notes started from now on use the new one
+    Crossfade  // sounding voices fade from the old routing to the new one over a few milliseconds
+};
 
 // VoiceHandler class manages polyphony by routing incoming note events to a collection of Voice objects.
 class VoiceHandler
 {
 public:
-    /// Constructor: Initialize the voice handler with a specified maximum polyphony.
-    /// @param maxPolyphony The maximum number of simultaneous voices (default is 8).
-    VoiceHandler(int maxPolyphony = 8)
-        : maxPolyphony(maxPolyphony)
+    /// Largest polyphony the pool is built for; prepare() allocates this many voices up front.
+    /// Idle voices cost nothing per block: the cost follows the voices that sound, not the polyphony setting
+    /// (Benchmarks/OutsetBench measures both).
+    static constexpr int maxVoices = 128;
+    /// Voices render at 1x, 2x or 4x the base rate: render rate r runs at (1 << r) times it.
+    static constexpr int numRenderRates = 3;
+    using RateOutputs = std::array<float*, numRenderRates>;       // one voice sum per render rate
+    using RateRamps = std::array<Voice::Ramps, numRenderRates>;   // the block's ramps at each render rate
+
+    /// Constructor: Initialize the voice handler with a specified polyphony.
+    /// No voices exist until prepare() is called.
+    /// @param polyphony The number of voices notes may use (default is 8).
+    VoiceHandler(int polyphony = 8)
+        : maxPolyphony(polyphony),
+          workerPool(&VoiceHandler::renderJob, this)
     {
         algIndex = 0;
-        voices.resize(maxPolyphony);
+        matrixAlgorithm.compile();
+    }
+
+    /// Builds the voice pool and starts the render workers. Call from prepareToPlay, never from the audio thread:
+    /// this is the only place voices and render buffers are allocated.
+    /// @param capacity Number of voices to allocate; setPolyphony can use up to this many without allocating.
+    /// @param sampleRate_ The base sample rate; oversampled voices run at multiples of it.
+    /// @param maxBlockSize Longest block, at the base rate, multi-threaded rendering is used for; longer blocks
+    /// render on the calling thread.
+    void prepare(int capacity, float sampleRate_, int maxBlockSize)
+    {
+        jassert(capacity > 0);
+        if (static_cast<int>(voices.size()) != capacity)
+        {
+            // One allocation for the whole pool: voices and their operators are stored inline
+            voices.assign(static_cast<size_t>(capacity), Voice());
+            slots.assign(static_cast<size_t>(capacity), VoiceSlot());
+            activeVoices.reserve(static_cast<size_t>(capacity));
+            renderGroups.reserve(static_cast<size_t>(capacity));
+            openGroups.reserve(static_cast<size_t>(capacity));
+            isListedActive.assign(static_cast<size_t>(capacity), false);
+            outgoingVoices.assign(static_cast<size_t>(capacity), Voice());
+            for (size_t i = 0; i < voices.size(); ++i)
+            {
+                voices[i].init();
+                voices[i].setAlgorithm(getSchedule(getCurrentAlgorithm()), getKernel(getCurrentAlgorithm()));
+                voices[i].setModMatrix(&modMatrix, uint32_t(i + 1));
+                voices[i].setMatrixAlgorithm(&matrixAlgorithm);
+                voices[i].setUnison(unison, unisonDetune, unisonSpread);
+            }
+            cycleTables.assign(static_cast<size_t>(capacity * cycleTableSize), 0.f);
+            captureVoices.assign(static_cast<size_t>(capacity), Voice());
+            attachCycleTables();
+        }
+        voiceBufferSize = juce::jmax(1, maxBlockSize) << (numRenderRates - 1);
+        // Left and right halves, for voices spread in stereo by unison
+        voiceBuffers.assign(static_cast<size_t>(capacity * 2 * voiceBufferSize), 0.f);
+        transitionBuffer.assign(static_cast<size_t>(2 * voiceBufferSize), 0.f);
+        workerPool.prepare(maxBlockSize, sampleRate_);
+        reset(sampleRate_);
+    }
+
+    /// Stops the render workers; prepare() starts them again.
+    void releaseResources()
+    {
+        workerPool.stop();
+    }
+
+    /// Number of threads rendering voices, the calling thread included. 1 renders everything on the audio
+    /// thread. Real-time safe: helper threads that are not running yet are spawned on the message thread
+    /// and join once started, see VoiceWorkerPool.
+    void setNumRenderThreads(int numThreads)
+    {
+        workerPool.setNumActiveWorkers(numThreads - 1);
+    }
+
+    /// Sets the rates voices render at. Fixed: every voice at maxFactor (1, 2 or 4) times the base rate.
+    /// Adaptive: each voice at the lowest rate up to maxFactor its estimated bandwidth allows, chosen
+    /// every block. Real-time safe; sounding voices crossfade to their new rate over the next blocks
+    /// (see startTransition), so renderBlock may still use the old rates for a few milliseconds.
+    void setOversampling(int maxFactor, bool adaptive)
+    {
+        maxRenderRate = maxFactor >= 4 ? 2 : (maxFactor >= 2 ? 1 : 0);
+        const bool modeChanges = adaptive != adaptiveRate;
+        adaptiveRate = adaptive;
+        for (int i = 0; i < static_cast<int>(voices.size()); ++i)
+        {
+            if (!isListedActive[size_t(i)])
+                setRenderRate(i, getIdleRate(i));
+            if (modeChanges)
+                applyRenderRate(i);
+        }
+    }
+
+    /// Gives every voice its own filter (see VoiceFilter.h), applied at the voice's render rate before the
+    /// voices are summed. Off, the voices are summed unfiltered. Real-time safe.
+    void setVoiceFiltering(bool enabled)
+    {
+        if (enabled == filterVoices)
+            return;
+        filterVoices = enabled;
+        filterBank.snapToTargets();
         for (auto& voice : voices)
         {
-            voice.init();
-            algSpace.setAlgorithm(voice.op, 0);
+            // left over from the last time filtering was on
+            voice.filter.s1 = voice.filter.s2 = 0.f;
+            voice.filterRight.s1 = voice.filterRight.s2 = 0.f;
         }
     }
 
+    /// Lets a voice whose operators hold still, e.g. a pad in its sustain, play back one cached cycle of its
+    /// output instead of evaluating them (see Voice::updateCycle). Real-time safe.
+    void setCycleCaching(bool enabled)
+    {
+        if (enabled == cycleCaching)
+            return;
+        cycleCaching = enabled;
+        attachCycleTables();
+    }
+
+    /// Stacks numLanes copies of every voice, detuned evenly across +-detuneCents and panned across
+    /// spread (0 mono, 1 hard left to hard right). A stack is one voice: polyphony and stealing count it once.
+    /// Real-time safe; sounding notes switch kernels on the next block.
+    void setUnison(int numLanes, float detuneCents, float spread)
+    {
+        numLanes = juce::jlimit(1, Operator::maxUnison, numLanes);
+        if (numLanes == unison && detuneCents == unisonDetune && spread == unisonSpread)
+            return;
+        const bool wasStereo = isStereo();
+        const bool kernelsChange = (numLanes > 1) != (unison > 1);
+        unison = numLanes;
+        unisonDetune = detuneCents;
+        unisonSpread = spread;
+        for (size_t i = 0; i < voices.size(); ++i)
+        {
+            auto& voice = voices[i];
+            voice.setUnison(unison, unisonDetune, unisonSpread);
+            if (isStereo() && !wasStereo)
+                voice.filterRight = voice.filter; // the right channel carries on from the mono filter
+            if (kernelsChange)
+                voice.setKernel(getKernel(slots[i].algorithm));
+        }
+    }
+
+    /// True while unison spreads the voices in stereo: renderBlock then needs right channel outputs.
+    bool isStereo() const { return unison > 1 && unisonSpread > 0.f; }
+
+    /// Cutoff, resonance, key tracking and envelope depth shared by the voice filters.
+    VoiceFilterBank& getFilterBank() { return filterBank; }
+
+    /// LFO routing read by every voice. Change it between blocks only, never while renderBlock runs.
+    ModMatrix& getModMatrix() { return modMatrix; }
+    const ModMatrix& getModMatrix() const { return modMatrix; }
+    /// What routes cost since the caller last cleared it: every voice's, gathered after each block, plus what
+    /// the caller adds for the global LFO
+    ModulationCost& getModulationCost() { return modulationCost; }
+
+    /// Changes how many voices notes may use (clamped to the prepared capacity). Real-time safe: nothing is
+    /// allocated, and voices beyond the new limit are released so they fade out on their own envelopes.
+    void setPolyphony(int polyphony)
+    {
+        polyphony = juce::jlimit(1, maxVoices, polyphony);
+        if (polyphony == maxPolyphony)
+            return;
+        maxPolyphony = polyphony;
+        for (int i = 0; i < static_cast<int>(voices.size()); ++i)
+        {
+            auto& slot = slots[i];
+            const bool usable = i < getUsableVoices();
+            if (!usable && slot.state == SlotState::Held)
+                releaseVoice(i);
+            if (!usable && slot.state == SlotState::Released)
+            {
+                // Out of reach of new notes and of stealing; the voice is freed once its tail ends
+                moveTo(i, SlotState::Retiring);
+                unlink(ageList, i, ageLink);
+            }
+            else if (usable && slot.state == SlotState::Retiring)
+            {
+                // Back within the limit: stealable again, as the youngest released voice
+                moveTo(i, SlotState::Released);
+                pushBack(ageList, i, ageLink);
+            }
+            // Idle voices join or leave the free list; sounding ones follow when they finish
+            if (slot.state == SlotState::Free || slot.state == SlotState::Unused)
+            {
+                moveTo(i, SlotState::Unused);
+                parkOrFree(i);
+            }
+        }
+    }
+
+    int getPolyphony() const { return maxPolyphony; }
+
     /// Destructor.
     ~VoiceHandler() = default;
+    /// Selects one of the 32 fixed algorithms. Real-time safe: voices switch to a precompiled schedule and
+    /// kernel, as set by setAlgorithmSwitchMode.
     void updateAlgorithm(int algIndex_)
     {
+        // The index selects a compiled kernel, so it must name one of the 32 algorithms
+        jassert(algIndex_ >= 0 && algIndex_ < AlgSpace::numAlgorithms);
+        algIndex_ = juce::jlimit(0, AlgSpace::numAlgorithms - 1, algIndex_);
         if (algIndex_ == algIndex)
             return;
-        for (auto& voice : voices)
-        {
-            voice.resetCache();
-            algSpace.setAlgorithm(voice.op, algIndex_);
-        }
         algIndex = algIndex_;
+        if (!matrixMode)
+            applyAlgorithm();
     };
+    void setAlgorithmSwitchMode(AlgSwitchMode mode) { algSwitchMode = mode; }
+    /// Renders with the user matrix routing (see setMatrixAlgorithm) instead of the fixed algorithm.
+    void setMatrixMode(bool enabled)
+    {
+        if (enabled == matrixMode)
+            return;
+        matrixMode = enabled;
+        applyAlgorithm();
+    }
+    /// Copies in new matrix depths and output levels. Voices read the copy, so in matrix mode sounding notes
+    /// follow the change from the next block on, keeping their state. Real-time safe.
+    void setMatrixAlgorithm(const MatrixAlgorithm& matrix)
+    {
+        matrixAlgorithm.depths = matrix.depths;
+        matrixAlgorithm.outputLevels = matrix.outputLevels;
+        matrixAlgorithm.compile();
+    }
+    /// Select the sine engine used by the operators (see FastSine.h for the error of each).
+    void setSineMode(SineMode mode)
+    {
+        if (mode == sineMode)
+            return;
+        sineMode = mode;
+        // Voices still playing an earlier algorithm keep it, in the new engine
+        for (size_t i = 0; i < voices.size(); ++i)
+        {
+            voices[i].setKernel(getKernel(slots[i].algorithm));
+        }
+    }
+    /// Choose which voice gives way when a note arrives and none is free.
+    void setStealPolicy(StealPolicy policy) { stealPolicy = policy; }
+    /// Note frequencies for notes started from now on; sounding notes keep their pitch. A copy, no allocation.
+    void setTuning(const TuningTable& table) { tuning = table; }
+
     /// Trigger a note on event.
-    /// If the note is already active, it retriggers that voice.
-    /// Otherwise, it assigns the note to an available voice, or steals one if necessary.
+    /// If the note is already held, it retriggers that voice.
+    /// Otherwise, it assigns the note to a free voice, or steals one if necessary.
+    /// Every step is O(1) except the Quietest policy, which compares the cached levels of at most
+    /// quietestCandidates voices.
     void noteOn(int note, int velocity)
     {
-        // If the note is already active, retrigger the voice.
-        if (activeNotes.find(note) != activeNotes.end())
+        if (note < 0 || note >= numNotes || voices.empty())
+            return;
+        const int owner = noteToVoice[note];
+        if (owner >= 0 && slots[owner].state == SlotState::Held)
         {
-            int voiceIndex = activeNotes[note];
-            voices[voiceIndex].noteOn(note, velocity);
+            // Retrigger: the envelopes continue from their current level, so there is no click
+            if (slots[owner].pendingNote)
+                slots[owner].velocity = velocity;
+            else
+                voices[owner].noteOn(note, velocity, tuning.getFrequency(note));
+            touch(owner);
+            return;
+        }
+        if (owner >= 0 && stealPolicy == StealPolicy::SameNote && !slots[owner].pendingNote
+            && slots[owner].state == SlotState::Released)
+        {
+            // Pick up the note's own release tail instead of starting a second copy
+            moveTo(owner, SlotState::Held);
+            voices[owner].noteOn(note, velocity, tuning.getFrequency(note));
+            touch(owner);
             return;
         }
-        // Find a free voice.
-        Voice* voice = findFreeVoice();
-        // If none is free, steal a voice.
-        if (!voice)
-            voice = stealVoice();
 
-        if (voice)
+        const int voiceIndex = popFront(freeList, stateLink);
+        if (voiceIndex >= 0)
         {
-            // Calculate the voice index (assumes voices vector is contiguous).
-            int voiceIndex = static_cast<int>(voice - &voices[0]);
-            voice->noteOn(note, velocity);
-            activeNotes[note] = voiceIndex;
+            startVoice(voiceIndex, note, velocity);
+            return;
         }
+        const int victim = chooseVictim();
+        if (victim >= 0)
+            stealVoice(victim, note, velocity);
     }
 
     /// Trigger a note off event for the given note.
     void noteOff(int note)
     {
-        auto it = activeNotes.find(note);
-        if (it != activeNotes.end())
-        {
-            int voiceIndex = it->second;
-            voices[voiceIndex].noteOff();
-            activeNotes.erase(it);
-        }
+        if (note < 0 || note >= numNotes)
+            return;
+        const int voiceIndex = noteToVoice[note];
+        if (voiceIndex >= 0 && slots[voiceIndex].state == SlotState::Held)
+            releaseVoice(voiceIndex);
     }
 
-    /// Generate the next audio sample by summing all active voice outputs.
-    /// @return The mixed audio sample from all voices.
-    float getNextSample()
+    /// Render a block of audio by summing the block output of every sounding voice into the sum for its render rate.
+    /// Voices drop out of the active list once their carriers have finished, so idle voices cost nothing.
+    /// With render workers enabled and enough work in the block, voices render in parallel into private
+    /// buffers that are then summed in list order, so the result is bit-identical to the single-threaded path.
+    /// Voice filtering also renders into the private buffers, so the filters can run on several voices at once.
+    /// So do voices rendered side by side in a VoiceBank, see groupVoices.
+    /// @param outputs One buffer per render rate, (1 << rate) * numSamples long, or null for rates above the
+    /// oversampling factor. They are overwritten, not accumulated into.
+    /// @param numSamples Number of samples to render, at the base rate.
+    /// @param ramps Parameter ramps for the block at each render rate, shared by all voices (see Smoothing.h).
+    /// @param rightOutputs The right channel's sums, like outputs, used while isStereo(): outputs then receive
+    /// the left channel. Without them, spread voices are mixed to mono.
+    /// @returns A mask with bit r set when a voice rendered into outputs[r].
+    int renderBlock(const RateOutputs& outputs, int numSamples, const RateRamps& ramps = {},
+                    const RateOutputs& rightOutputs = {})
     {
-        float output = 0.f;
-        for (auto& voice : voices)
+        stereo = isStereo() && rightOutputs[0] != nullptr;
+        for (int rate = 0; rate < numRenderRates; ++rate)
         {
-            output += voice.render();
+            if (outputs[rate] != nullptr)
+                juce::FloatVectorOperations::clear(outputs[rate], numSamples << rate);
+            if (stereo && rightOutputs[rate] != nullptr)
+                juce::FloatVectorOperations::clear(rightOutputs[rate], numSamples << rate);
         }
-        return output;
+        updateRenderRates();
+        startAlgorithmTransitions();
+
+        if (filterVoices)
+            filterBank.beginBlock();
+
+        int ratesUsed = 0;
+        const int numVoices = static_cast<int>(activeVoices.size());
+        const bool parallel = shouldRenderInParallel(numVoices, numSamples);
+        const bool buffered = (numSamples << (numRenderRates - 1)) <= voiceBufferSize;
+        // In parallel the groups shrink so every thread gets one
+        const int numThreads = workerPool.getNumActiveWorkers() + 1;
+        const int numGroups = groupVoices(!buffered ? 1 : parallel ? (numVoices + numThreads - 1) / numThreads
+                                                                  : VoiceBank::lanes);
+        if (parallel || filterVoices || numGroups < numVoices)
+        {
+            jassert((numSamples << (numRenderRates - 1)) <= voiceBufferSize);
+            blockSamples = numSamples;
+            blockRamps = &ramps;
+            if (parallel)
+                workerPool.run(numGroups);
+            else
+            {
+                for (int i = 0; i < numGroups; ++i)
+                    renderJob(this, i);
+            }
+            if (filterVoices)
+                filterVoiceBuffers(numVoices, numSamples);
+            for (int i = 0; i < numVoices; ++i)
+            {
+                const int rate = slots[activeVoices[i]].rate;
+                if (slots[activeVoices[i]].previousRate >= 0)
+                    ratesUsed |= renderTransition(activeVoices[i], outputs, rightOutputs, numSamples, ramps);
+                else
+                {
+                    juce::FloatVectorOperations::add(outputs[rate], getVoiceBuffer(i), numSamples << rate);
+                    if (stereo)
+                        juce::FloatVectorOperations::add(rightOutputs[rate], getVoiceBufferRight(i), numSamples << rate);
+                }
+                ratesUsed |= 1 << rate;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < numVoices; ++i)
+            {
+                const int rate = slots[activeVoices[i]].rate;
+                jassert(outputs[rate] != nullptr && (!stereo || rightOutputs[rate] != nullptr));
+                if (slots[activeVoices[i]].previousRate >= 0)
+                    ratesUsed |= renderTransition(activeVoices[i], outputs, rightOutputs, numSamples, ramps);
+                else
+                    renderVoice(activeVoices[i], outputs[rate], stereo ? rightOutputs[rate] : nullptr,
+                                numSamples << rate, ramps[rate]);
+                ratesUsed |= 1 << rate;
+            }
+        }
+
+        for (size_t i = 0; i < activeVoices.size();)
+        {
+            const int voiceIndex = activeVoices[i];
+            auto& voice = voices[voiceIndex];
+            slots[voiceIndex].level = voice.getLevel();
+            voice.takeModulationCost(modulationCost);
+            if (voice.isActive() || slots[voiceIndex].pendingNote || slots[voiceIndex].previousRate >= 0)
+            {
+                ++i;
+                continue;
+            }
+            // Voice finished: hand it back to the free list and swap-remove it from the active list
+            freeVoice(voiceIndex);
+            setRenderRate(voiceIndex, getIdleRate(voiceIndex));
+            isListedActive[voiceIndex] = false;
+            activeVoices[i] = activeVoices.back();
+            activeVoices.pop_back();
+        }
+        return ratesUsed;
     }
 
-    /// Reset all voices and clear active note mappings.
-    /// @param sampleRate The current sample rate to pass to each voice.
+    /// Number of voices currently being rendered.
+    int getNumActiveVoices() const { return static_cast<int>(activeVoices.size()); }
+
+    /// Stop all voices and clear the note assignments.
+    /// @param sampleRate The base sample rate; voices run at their render rate's multiple of it.
     void reset(float sampleRate_)
     {
-        for (auto& voice : voices)
+        sampleRate = sampleRate_;
+        fastReleaseSamples = juce::jmax(1, juce::roundToInt(fastReleaseSeconds * sampleRate));
+        transitionSamples = juce::jmax(1, juce::roundToInt(transitionSeconds * sampleRate));
+        noteToVoice.fill(-1);
+        freeList = heldList = releasedList = ageList = {};
+        for (int i = 0; i < static_cast<int>(voices.size()); ++i)
         {
-            voice.reset(sampleRate_);
+            slots[i] = {};
+            setVoiceAlgorithm(i, getCurrentAlgorithm());
+            voices[i].reset(sampleRate);
+            voices[i].stop();
+            setRenderRate(i, adaptiveRate ? 0 : maxRenderRate);
+            isListedActive[i] = false;
+            parkOrFree(i);
         }
-        activeNotes.clear();
-        sampleRate = sampleRate_;
+        activeVoices.clear();
+        filterBank.snapToTargets();
     }
-	void resetCaches()
-	{
-		for (auto& voice : voices)
-		{
-			voice.resetCache();
-		}
-	}
-    /// Stops all currently playing voices.
+
+    /// Releases all held notes.
     void allNotesOff()
     {
-        for (auto& voice : voices)
-        {
-            voice.noteOff();
-        }
-        activeNotes.clear();
+        while (heldList.head >= 0)
+            releaseVoice(heldList.head);
     }
 	std::vector<Voice>& getVoices() { return voices; } // Expose the voices for external access.
 private:
+    enum class SlotState : uint8_t
+    {
+        Free,     // in freeList, ready for a note
+        Unused,   // idle and beyond the polyphony limit
+        Held,     // key down (or waiting for a fast release to finish before starting)
+        Released, // key up, release tail still sounding
+        Retiring  // released and beyond a lowered polyphony limit: on no list, never stolen
+    };
+
+    static constexpr int numNotes = 128;
+    static constexpr int stateLink = 0; // links for the free, held or released list
+    static constexpr int ageLink = 1;   // links for the list of all sounding voices, oldest first
+    static constexpr float fastReleaseSeconds = 0.003f; // fade applied to stolen voices
+    static constexpr float transitionSeconds = 0.005f;  // crossfade of a voice changing rate or routing
+    static constexpr int quietestCandidates = 16; // oldest sounding voices the Quietest policy compares
+
+    /// Allocation bookkeeping for one voice. Lists are intrusive: the links live here, indexed by voice.
+    struct VoiceSlot
+    {
+        int prev[2] = { -1, -1 };
+        int next[2] = { -1, -1 };
+        SlotState state = SlotState::Free;
+        int note = -1;
+        int velocity = 0;
+        bool pendingNote = false; // note/velocity start once the voice's fast release has finished
+        float level = 0.f;        // carrier level after the last rendered block
+        int rate = 0;             // render rate: the voice runs at (1 << rate) times the base rate
+        int previousRate = -1;    // rate the voice is moving from while it crossfades, else -1
+        int transitionLeft = 0;   // samples of that crossfade still to render, at the base rate
+        int algorithm = 0;        // routing the voice plays, see getCurrentAlgorithm
+        bool algorithmPending = false; // crossfade to the current algorithm once no other crossfade runs
+    };
+
+    struct VoiceList
+    {
+        int head = -1;
+        int tail = -1;
+    };
+
     std::vector<Voice> voices;         // Array of voices for polyphony.
-    int maxPolyphony;                  // Maximum number of voices.
-    std::map<int, int> activeNotes;    // Mapping from MIDI note numbers to voice indices.
+    std::vector<VoiceSlot> slots;      // Per voice allocation state, same indexing as voices.
+    int maxPolyphony;                  // Number of voices notes may use; the pool may hold more.
+    std::array<int, numNotes> noteToVoice; // Voice most recently started for each MIDI note, or -1.
+    VoiceList freeList, heldList, releasedList, ageList;
+    StealPolicy stealPolicy = StealPolicy::ReleasedFirst;
+    int fastReleaseSamples = 1;        // at the base rate
+    int transitionSamples = 1;         // at the base rate
+    int maxRenderRate = 0;             // the fixed render rate, or the highest adaptive oversampling may pick
+    bool adaptiveRate = false;
+    bool filterVoices = false;
+    VoiceFilterBank filterBank;
+    TuningTable tuning;
+    ModMatrix modMatrix;
+    ModulationCost modulationCost;     // see getModulationCost
+    std::vector<int> activeVoices;     // Indices of voices that are sounding, in no particular order.
+    std::vector<bool> isListedActive;  // Per voice: is it in activeVoices?
 
-    /// Searches for a free voice (one that is not active).
-    /// @return Pointer to a free Voice; otherwise nullptr if all voices are busy.
-    Voice* findFreeVoice()
+    /// Voices one render job renders, by active-list position: side by side in a VoiceBank when there
+    /// are several, all playing algorithm at rate
+    struct RenderGroup
     {
-        for (auto& voice : voices)
+        int rate = 0;
+        int algorithm = 0;
+        int numVoices = 0;
+        std::array<int, VoiceBank::lanes> positions{};
+    };
+    std::vector<RenderGroup> renderGroups; // the jobs of the block being rendered, see groupVoices
+    std::vector<int> openGroups;       // groups groupVoices can still add voices to
+
+    // Multi-threaded rendering
+    VoiceWorkerPool workerPool;
+    std::vector<float> voiceBuffers;   // One private block per active-list position, 2 * voiceBufferSize samples each.
+    std::vector<Voice> outgoingVoices; // Per voice: the copy fading out while it crossfades, see startTransition.
+    std::vector<float> transitionBuffer; // Scratch for renderTransition, 2 * voiceBufferSize samples.
+    static constexpr int cycleTableSize = Voice::cycleBufferSize;
+    std::vector<float> cycleTables;    // One cached cycle per voice, cycleTableSize samples each.
+    std::vector<Voice> captureVoices;  // Per voice: the copy rendering its cached cycle.
+    bool cycleCaching = true;
+    int voiceBufferSize = 0;
+    int blockSamples = 0;              // Block being rendered into the private buffers
+    const RateRamps* blockRamps = nullptr;
+    bool stereo = false;               // isStereo() for the block being rendered
+
+    // Unison, see setUnison
+    int unison = 1;
+    float unisonDetune = 0.f;
+    float unisonSpread = 0.f;
+
+    /// Adds one voice's block to output, and to right when it is not null.
+    /// Touches only that voice and its slot, so voices can render concurrently.
+    void renderVoice(int voiceIndex, float* output, float* right, int numSamples, const Voice::Ramps& ramps)
+    {
+        auto& voice = voices[voiceIndex];
+        auto& slot = slots[voiceIndex];
+        if (slot.pendingNote && voice.getFadeSamplesLeft() < numSamples)
+        {
+            // A stolen voice: finish the fade, then start the new note on the very next sample
+            const int fadeLength = voice.getFadeSamplesLeft();
+            voice.renderBlock(output, fadeLength, ramps, right);
+            voice.stop();
+            if (slot.algorithm != getCurrentAlgorithm())
+                setVoiceAlgorithm(voiceIndex, getCurrentAlgorithm());
+            voice.noteOn(slot.note, slot.velocity, tuning.getFrequency(slot.note));
+            slot.pendingNote = false;
+            voice.renderBlock(output + fadeLength, numSamples - fadeLength, Voice::advanced(ramps, fadeLength),
+                              right != nullptr ? right + fadeLength : nullptr);
+        }
+        else
+        {
+            voice.renderBlock(output, numSamples, ramps, right);
+        }
+    }
+
+    // Blocks with less work than this stay on the audio thread: waking the workers would cost more than it saves
+    static constexpr int minParallelVoiceSamples = 2048;
+
+    bool shouldRenderInParallel(int numVoices, int numSamples) const
+    {
+        const int maxRenderSamples = numSamples << maxRenderRate;
+        return workerPool.getNumActiveWorkers() > 0 && numVoices >= 2 && (numSamples << (numRenderRates - 1)) <= voiceBufferSize
+            && numVoices * maxRenderSamples >= minParallelVoiceSamples;
+    }
+
+    float* getVoiceBuffer(int job) { return voiceBuffers.data() + job * 2 * voiceBufferSize; }
+    float* getVoiceBufferRight(int job) { return getVoiceBuffer(job) + voiceBufferSize; }
+
+    /// Runs the voice filters over the private buffers, up to VoiceFilterBank::lanes voices of one render rate
+    /// at a time; in stereo each channel of a voice is a lane. Voices changing rate are filtered in renderTransition.
+    void filterVoiceBuffers(int numVoices, int numSamples)
+    {
+        for (int rate = 0; rate < numRenderRates; ++rate)
+        {
+            std::array<VoiceFilterState*, VoiceFilterBank::lanes> states;
+            std::array<float*, VoiceFilterBank::lanes> buffers;
+            int numLanes = 0;
+            const int lanesPerVoice = stereo ? 2 : 1;
+            for (int i = 0; i <= numVoices; ++i)
+            {
+                const bool flush = i == numVoices || numLanes + lanesPerVoice > VoiceFilterBank::lanes;
+                if (flush && numLanes > 0)
+                {
+                    filterBank.process(states.data(), buffers.data(), numLanes, numSamples << rate, getRenderSampleRate(rate));
+                    numLanes = 0;
+                }
+                if (i == numVoices)
+                    break;
+                const auto& slot = slots[activeVoices[i]];
+                if (slot.rate != rate || slot.previousRate >= 0)
+                    continue;
+                states[size_t(numLanes)] = &voices[activeVoices[i]].filter;
+                buffers[size_t(numLanes)] = getVoiceBuffer(i);
+                ++numLanes;
+                if (stereo)
+                {
+                    states[size_t(numLanes)] = &voices[activeVoices[i]].filterRight;
+                    buffers[size_t(numLanes)] = getVoiceBufferRight(i);
+                    ++numLanes;
+                }
+            }
+        }
+    }
+
+    /*
+    groupVoices splits the active list into the block's render jobs, renderGroups,
+    and returns how many there are. Voices that play the same algorithm at the same
+    rate and render like its kernel alone (see Voice::canShareLanes) share a job of
+    VoiceBank::minVoices to maxLanes voices, rendered side by side in a VoiceBank;
+    every other voice, and every voice while unison, the exact sine engine or a
+    voice LFO or noise route is on, is a job of its own.
+    */
+    int groupVoices(int maxLanes)
+    {
+        renderGroups.clear();
+        openGroups.clear();
+        // std::sin is scalar, so the exact engine gains nothing from lanes
+        const bool lanes = maxLanes > 1 && unison == 1 && sineMode != SineMode::Exact
+                           && modMatrix.getRoutes(ModSource::VoiceLfo).isEmpty()
+                           && modMatrix.getRoutes(ModSource::Noise).isEmpty();
+        for (int i = 0; i < static_cast<int>(activeVoices.size()); ++i)
+        {
+            const int voiceIndex = activeVoices[size_t(i)];
+            const auto& slot = slots[size_t(voiceIndex)];
+            const bool shares = lanes && slot.previousRate < 0 && !slot.pendingNote
+                                && slot.algorithm != matrixAlgorithmId && voices[size_t(voiceIndex)].canShareLanes();
+            if (shares)
+            {
+                const auto open = std::find_if(openGroups.begin(), openGroups.end(), [&](int g) {
+                    const auto& group = renderGroups[size_t(g)];
+                    return group.rate == slot.rate && group.algorithm == slot.algorithm;
+                });
+                if (open != openGroups.end())
+                {
+                    auto& group = renderGroups[size_t(*open)];
+                    group.positions[size_t(group.numVoices++)] = i;
+                    if (group.numVoices == juce::jmin(maxLanes, VoiceBank::lanes))
+                        openGroups.erase(open);
+                    continue;
+                }
+                openGroups.push_back(static_cast<int>(renderGroups.size()));
+            }
+            RenderGroup group;
+            group.rate = slot.rate;
+            group.algorithm = slot.algorithm;
+            group.numVoices = 1;
+            group.positions[0] = i;
+            renderGroups.push_back(group);
+        }
+        // Groups too small for a bank go back to a job per voice
+        const size_t numGrouped = renderGroups.size();
+        for (size_t g = 0; g < numGrouped; ++g)
+        {
+            while (renderGroups[g].numVoices > 1 && renderGroups[g].numVoices < VoiceBank::minVoices)
+            {
+                RenderGroup single = renderGroups[g];
+                single.numVoices = 1;
+                single.positions[0] = renderGroups[g].positions[size_t(--renderGroups[g].numVoices)];
+                renderGroups.push_back(single);
+            }
+        }
+        return static_cast<int>(renderGroups.size());
+    }
+
+    /// Worker pool job: renders the voices of renderGroups[job] into their private buffers.
+    static void renderJob(void* context, int job)
+    {
+        auto& handler = *static_cast<VoiceHandler*>(context);
+        const auto& group = handler.renderGroups[size_t(job)];
+        if (group.numVoices > 1)
+        {
+            handler.renderGroup(group);
+            return;
+        }
+        const int position = group.positions[0];
+        const int voiceIndex = handler.activeVoices[size_t(position)];
+        if (handler.slots[size_t(voiceIndex)].previousRate >= 0)
+            return; // moving between rates: rendered by the calling thread, see renderTransition
+        const int rate = handler.slots[size_t(voiceIndex)].rate;
+        float* buffer = handler.getVoiceBuffer(position);
+        float* right = handler.stereo ? handler.getVoiceBufferRight(position) : nullptr;
+        juce::FloatVectorOperations::clear(buffer, handler.blockSamples << rate);
+        if (right != nullptr)
+            juce::FloatVectorOperations::clear(right, handler.blockSamples << rate);
+        handler.renderVoice(voiceIndex, buffer, right, handler.blockSamples << rate, (*handler.blockRamps)[size_t(rate)]);
+    }
+
+    void renderGroup(const RenderGroup& group)
+    {
+        std::array<Voice*, VoiceBank::lanes> bankVoices;
+        std::array<float*, VoiceBank::lanes> buffers;
+        const int numSamples = blockSamples << group.rate;
+        for (size_t k = 0; k < size_t(group.numVoices); ++k)
+        {
+            bankVoices[k] = &voices[size_t(activeVoices[size_t(group.positions[k])])];
+            buffers[k] = getVoiceBuffer(group.positions[k]);
+            juce::FloatVectorOperations::clear(buffers[k], numSamples);
+        }
+        VoiceBank bank;
+        bank.renderBlock(bankVoices.data(), buffers.data(), group.numVoices, numSamples,
+                         (*blockRamps)[size_t(group.rate)], sineMode, group.algorithm);
+    }
+
+    float getRenderSampleRate(int rate) const { return sampleRate * static_cast<float>(1 << rate); }
+
+    /// Rate for a voice that is not sounding: moving it costs no crossfade
+    int getIdleRate(int voiceIndex) const
+    {
+        return adaptiveRate ? juce::jmin(slots[voiceIndex].rate, maxRenderRate) : maxRenderRate;
+    }
+
+    void setRenderRate(int voiceIndex, int rate)
+    {
+        if (slots[voiceIndex].rate == rate)
+            return;
+        slots[voiceIndex].rate = rate;
+        applyRenderRate(voiceIndex);
+    }
+
+    /// Fixed oversampling keeps the operators' smoothing and feedback per sample at any factor. Adaptive
+    /// stretches them with the rate, so a voice sounds the same at every rate it moves between.
+    void applyRenderRate(int voiceIndex)
+    {
+        const int rate = slots[voiceIndex].rate;
+        voices[voiceIndex].setSampleRate(getRenderSampleRate(rate), 1 << rate, adaptiveRate ? float(1 << rate) : 1.f);
+    }
+
+    // Highest voice bandwidth, relative to the base rate, that render rates 0 and 1 take without audible
+    // aliasing. At 1x it stays below Nyquist; at 2x its images fold above 28 kHz (at 48 kHz), where the
+    // decimator removes them. Anything wider renders at 4x.
+    static constexpr std::array<float, numRenderRates - 1> rateBandwidthLimits { 0.45f, 1.4f };
+    // A voice only moves down to a lower rate once its bandwidth is this far inside that rate's limit,
+    // so a bandwidth hovering at a limit does not flip the voice between rates every block
+    static constexpr float rateDownMargin = 0.8f;
+
+    static int requiredRate(float relativeBandwidth)
+    {
+        int rate = 0;
+        while (rate < numRenderRates - 1 && relativeBandwidth > rateBandwidthLimits[size_t(rate)])
+            ++rate;
+        return rate;
+    }
+
+    /*
+    updateRenderRates starts a transition for each sounding voice not at its rate: the
+    fixed rate, or with adaptive oversampling the lowest rate its estimated bandwidth
+    allows (see Voice::estimateBandwidth). Fading voices keep their rate, since their
+    fade is counted in samples, and so do voices still finishing a transition.
+    */
+    void updateRenderRates()
+    {
+        for (const int voiceIndex : activeVoices)
+        {
+            auto& slot = slots[voiceIndex];
+            if (voices[voiceIndex].isFading() || slot.pendingNote || slot.previousRate >= 0)
+                continue;
+            int rate = maxRenderRate;
+            if (adaptiveRate)
+            {
+                const float bandwidth = voices[voiceIndex].estimateBandwidth() / sampleRate;
+                rate = requiredRate(bandwidth);
+                if (rate < slot.rate)
+                    rate = juce::jmin(slot.rate, requiredRate(bandwidth / rateDownMargin));
+                rate = juce::jmin(rate, maxRenderRate);
+            }
+            if (slot.level == 0.f)
+                setRenderRate(voiceIndex, rate); // nothing rendered yet, e.g. a new note: no crossfade needed
+            else if (rate != slot.rate)
+                startTransition(voiceIndex, rate);
+        }
+    }
+
+    /*
+    startAlgorithmTransitions starts the crossfade to the current algorithm of the
+    voices waiting for one, at their present rate. A voice already in a transition
+    waits for it to finish. Fading voices are left alone: a stolen voice takes the new
+    algorithm with its next note, and a released one finishes on the old.
+    */
+    void startAlgorithmTransitions()
+    {
+        for (const int voiceIndex : activeVoices)
+        {
+            auto& slot = slots[voiceIndex];
+            if (!slot.algorithmPending || voices[voiceIndex].isFading() || slot.pendingNote || slot.previousRate >= 0)
+                continue;
+            if (slot.level == 0.f)
+                setVoiceAlgorithm(voiceIndex, getCurrentAlgorithm()); // nothing audible to fade from
+            else
+                startTransition(voiceIndex, slot.rate);
+        }
+    }
+
+    /*
+    startTransition moves a sounding voice to rate and, when one is pending, to the
+    current algorithm. The voice sums of all rates reach the output with the same
+    latency, but a path whose input stops abruptly rings in its decimation filter, and
+    a routing that changes mid-note jumps. So for transitionSamples the voice plays
+    both ways: a copy carries on at the old rate and routing and fades out while the
+    voice, switched over with its phases and envelope stages intact, fades in (see
+    renderTransition). The fade is counted in samples, so it sounds the same whatever
+    the host's block size and may span several blocks. A rate change alone renders the
+    same spectrum both ways, since a voice only moves down once it fits the lower rate.
+    */
+    void startTransition(int voiceIndex, int rate)
+    {
+        auto& slot = slots[voiceIndex];
+        auto& outgoing = outgoingVoices[size_t(voiceIndex)];
+        outgoing = voices[voiceIndex];
+        // The voice may capture a new cycle into the table they share; the copy's operators are in step with it
+        outgoing.setCycleBuffer(nullptr);
+        slot.previousRate = slot.rate;
+        slot.transitionLeft = transitionSamples;
+        setRenderRate(voiceIndex, rate);
+        if (slot.algorithmPending)
+            setVoiceAlgorithm(voiceIndex, getCurrentAlgorithm());
+    }
+
+    /// Renders a block of a voice in transition: the outgoing copy until its fade ends, and the voice.
+    /// @returns The mask of the rates rendered into.
+    int renderTransition(int voiceIndex, const RateOutputs& outputs, const RateOutputs& rightOutputs, int numSamples,
+                         const RateRamps& ramps)
+    {
+        auto& slot = slots[voiceIndex];
+        const int from = slot.previousRate;
+        const int to = slot.rate;
+        const int fadePosition = transitionSamples - slot.transitionLeft;
+        const int fadeLength = juce::jmin(numSamples, slot.transitionLeft);
+        renderCrossfade(voiceIndex, false, from, outputs[from], stereo ? rightOutputs[from] : nullptr, fadeLength,
+                        ramps[from], fadePosition);
+        renderCrossfade(voiceIndex, true, to, outputs[to], stereo ? rightOutputs[to] : nullptr, numSamples, ramps[to],
+                        fadePosition);
+        slot.transitionLeft -= fadeLength;
+        if (slot.transitionLeft == 0)
+            slot.previousRate = -1;
+        return (1 << from) | (1 << to);
+    }
+
+    /// Adds numSamples (at the base rate) of a voice in transition, rendered at rate, to output (and right,
+    /// when not null): the voice fading in, or its outgoing copy fading out, fadePosition samples into the fade.
+    void renderCrossfade(int voiceIndex, bool fadeIn, int rate, float* output, float* right, int numSamples,
+                         const Voice::Ramps& ramps, int fadePosition)
+    {
+        jassert(output != nullptr);
+        auto& voice = fadeIn ? voices[voiceIndex] : outgoingVoices[size_t(voiceIndex)];
+        numSamples <<= rate;
+        std::array<float*, 2> buffers { transitionBuffer.data(), transitionBuffer.data() + voiceBufferSize };
+        const int numChannels = right != nullptr ? 2 : 1;
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::clear(buffers[size_t(channel)], numSamples);
+        if (fadeIn)
+            renderVoice(voiceIndex, buffers[0], right != nullptr ? buffers[1] : nullptr, numSamples, ramps);
+        else
+            voice.renderBlock(buffers[0], numSamples, ramps, right != nullptr ? buffers[1] : nullptr);
+        if (filterVoices)
+        {
+            std::array<VoiceFilterState*, 2> states { &voice.filter, &voice.filterRight };
+            filterBank.process(states.data(), buffers.data(), numChannels, numSamples, getRenderSampleRate(rate));
+        }
+        const float step = 1.f / static_cast<float>(transitionSamples << rate);
+        const int start = fadePosition << rate;
+        std::array<float*, 2> outputs { output, right };
+        for (int channel = 0; channel < numChannels; ++channel)
         {
-            if (!voice.isActive())
-                return &voice;
+            const float* buffer = buffers[size_t(channel)];
+            float* destination = outputs[size_t(channel)];
+            for (int t = 0; t < numSamples; ++t)
+            {
+                const float gain = juce::jmin(1.f, static_cast<float>(start + t + 1) * step);
+                destination[t] += buffer[t] * (fadeIn ? gain : 1.f - gain);
+            }
+        }
+    }
+
+    /// Voices notes may be assigned to: the polyphony setting, limited to what prepare() allocated.
+    int getUsableVoices() const { return juce::jmin(maxPolyphony, static_cast<int>(voices.size())); }
+
+    /// Adds a voice to the active list when a note starts on it.
+    void markActive(int voiceIndex)
+    {
+        if (isListedActive[voiceIndex])
+            return;
+        isListedActive[voiceIndex] = true;
+        activeVoices.push_back(voiceIndex);
+    }
+
+    void pushBack(VoiceList& list, int voiceIndex, int link)
+    {
+        auto& slot = slots[voiceIndex];
+        slot.prev[link] = list.tail;
+        slot.next[link] = -1;
+        if (list.tail >= 0)
+            slots[list.tail].next[link] = voiceIndex;
+        else
+            list.head = voiceIndex;
+        list.tail = voiceIndex;
+    }
+
+    void unlink(VoiceList& list, int voiceIndex, int link)
+    {
+        auto& slot = slots[voiceIndex];
+        if (slot.prev[link] >= 0)
+            slots[slot.prev[link]].next[link] = slot.next[link];
+        else
+            list.head = slot.next[link];
+        if (slot.next[link] >= 0)
+            slots[slot.next[link]].prev[link] = slot.prev[link];
+        else
+            list.tail = slot.prev[link];
+        slot.prev[link] = slot.next[link] = -1;
+    }
+
+    int popFront(VoiceList& list, int link)
+    {
+        const int voiceIndex = list.head;
+        if (voiceIndex >= 0)
+            unlink(list, voiceIndex, link);
+        return voiceIndex;
+    }
+
+    VoiceList* stateList(SlotState state)
+    {
+        switch (state)
+        {
+            case SlotState::Free:     return &freeList;
+            case SlotState::Held:     return &heldList;
+            case SlotState::Released: return &releasedList;
+            case SlotState::Unused:
+            case SlotState::Retiring: break;
         }
         return nullptr;
     }
 
-    /// Implements a simple voice stealing strategy by selecting the first active voice.
-    /// More sophisticated voice-stealing logic can be implemented as needed.
-    /// @return Pointer to a stolen Voice (after calling noteOff() on it).
-    Voice* stealVoice()
+    /// Moves a voice to the list for its new state.
+    void moveTo(int voiceIndex, SlotState state)
     {
-        for (auto& voice : voices)
+        auto& slot = slots[voiceIndex];
+        if (auto* list = stateList(slot.state))
+            unlink(*list, voiceIndex, stateLink);
+        slot.state = state;
+        if (auto* list = stateList(state))
+            pushBack(*list, voiceIndex, stateLink);
+    }
+
+    /// Makes a voice the youngest sounding voice and makes sure it is rendered.
+    void touch(int voiceIndex)
+    {
+        unlink(ageList, voiceIndex, ageLink);
+        pushBack(ageList, voiceIndex, ageLink);
+        markActive(voiceIndex);
+    }
+
+    void startVoice(int voiceIndex, int note, int velocity)
+    {
+        auto& slot = slots[voiceIndex];
+        slot.state = SlotState::Unused; // already popped from freeList
+        moveTo(voiceIndex, SlotState::Held);
+        slot.note = note;
+        slot.level = 0.f;
+        noteToVoice[note] = voiceIndex;
+        if (slot.algorithm != getCurrentAlgorithm())
+            setVoiceAlgorithm(voiceIndex, getCurrentAlgorithm());
+        voices[voiceIndex].noteOn(note, velocity, tuning.getFrequency(note));
+        touch(voiceIndex);
+    }
+
+    void releaseVoice(int voiceIndex)
+    {
+        auto& slot = slots[voiceIndex];
+        moveTo(voiceIndex, SlotState::Released);
+        if (slot.pendingNote)
         {
-            if (voice.isActive())
+            // The new note never started; let the fade finish and free the voice
+            slot.pendingNote = false;
+            if (noteToVoice[slot.note] == voiceIndex)
+                noteToVoice[slot.note] = -1;
+            return;
+        }
+        voices[voiceIndex].noteOff();
+    }
+
+    /// Hands a finished voice back to the free list, or parks it if polyphony was lowered.
+    void freeVoice(int voiceIndex)
+    {
+        auto& slot = slots[voiceIndex];
+        if (slot.note >= 0 && noteToVoice[slot.note] == voiceIndex)
+            noteToVoice[slot.note] = -1;
+        slot.note = -1;
+        slot.pendingNote = false;
+        if (slot.state != SlotState::Retiring) // retiring voices already left the age list
+            unlink(ageList, voiceIndex, ageLink);
+        moveTo(voiceIndex, SlotState::Unused);
+        parkOrFree(voiceIndex);
+    }
+
+    void parkOrFree(int voiceIndex)
+    {
+        slots[voiceIndex].state = SlotState::Unused;
+        if (voiceIndex < getUsableVoices())
+            moveTo(voiceIndex, SlotState::Free);
+    }
+
+    /// Picks the sounding voice to give way according to the steal policy. Only voices within the
+    /// polyphony limit are on the age and released lists, so every policy stays below it.
+    int chooseVictim()
+    {
+        switch (stealPolicy)
+        {
+            case StealPolicy::Oldest:
+                return ageList.head;
+
+            case StealPolicy::Quietest:
             {
-                voice.noteOff();
-                return &voice;
+                // The quietest of the oldest few: a newer note is rarely the one to cut, and the
+                // search stays bounded however large the polyphony
+                int quietest = -1;
+                int candidates = 0;
+                for (int v = ageList.head; v >= 0 && candidates < quietestCandidates; v = slots[v].next[ageLink], ++candidates)
+                {
+                    if (quietest < 0 || slots[v].level < slots[quietest].level)
+                        quietest = v;
+                }
+                return quietest;
             }
+
+            case StealPolicy::ReleasedFirst:
+            case StealPolicy::SameNote:
+                break;
         }
-        return nullptr; // This should not occur if maxPolyphony > 0.
+        // Voices already in their release are the least missed; otherwise the oldest note goes
+        return releasedList.head >= 0 ? releasedList.head : ageList.head;
+    }
+
+    /*
+    stealVoice gives a sounding voice to a new note. The old note is faded out over
+    fastReleaseSamples instead of being cut, and the new note starts on the same voice as
+    soon as the fade has finished (see renderBlock).
+    */
+    void stealVoice(int voiceIndex, int note, int velocity)
+    {
+        auto& slot = slots[voiceIndex];
+        if (slot.note >= 0 && noteToVoice[slot.note] == voiceIndex)
+            noteToVoice[slot.note] = -1;
+        moveTo(voiceIndex, SlotState::Held);
+        slot.note = note;
+        slot.velocity = velocity;
+        slot.pendingNote = true;
+        noteToVoice[note] = voiceIndex;
+        voices[voiceIndex].fastRelease(fastReleaseSamples << slot.rate);
+        touch(voiceIndex);
     }
 private:
+    void attachCycleTables()
+    {
+        for (size_t i = 0; i < voices.size(); ++i)
+        {
+            if (cycleCaching)
+                voices[i].setCycleBuffer(cycleTables.data() + i * cycleTableSize, &captureVoices[i]);
+            else
+                voices[i].setCycleBuffer(nullptr);
+        }
+    }
+
+    // VoiceSlot::algorithm of voices playing the matrix routing; the fixed algorithms are their index
+    static constexpr int matrixAlgorithmId = AlgSpace::numAlgorithms;
+
+    int getCurrentAlgorithm() const { return matrixMode ? matrixAlgorithmId : algIndex; }
+    const AlgSchedule& getSchedule(int algorithm) const
+    {
+        return algorithm == matrixAlgorithmId ? matrixAlgorithm.schedule : algSpace.getSchedule(algorithm);
+    }
+    Voice::RenderKernel getKernel(int algorithm) const
+    {
+        if (unison > 1)
+            return algorithm == matrixAlgorithmId ? Voice::getMatrixUnisonKernel(sineMode)
+                                                  : Voice::getUnisonKernels(sineMode)[algorithm];
+        return algorithm == matrixAlgorithmId ? Voice::getMatrixKernel(sineMode) : Voice::getKernels(sineMode)[algorithm];
+    }
+    /// Touches only that voice and its slot, so it is safe from renderVoice on a render worker
+    void setVoiceAlgorithm(int voiceIndex, int algorithm)
+    {
+        // Pick the compile-time specialised kernel once here; voices then render without routing branches
+        voices[voiceIndex].setAlgorithm(getSchedule(algorithm), getKernel(algorithm));
+        slots[voiceIndex].algorithm = algorithm;
+        slots[voiceIndex].algorithmPending = false;
+    }
+    /// Moves the voices to the current algorithm as algSwitchMode says. No allocation: only pointers change.
+    void applyAlgorithm()
+    {
+        const int algorithm = getCurrentAlgorithm();
+        for (int i = 0; i < static_cast<int>(voices.size()); ++i)
+        {
+            auto& slot = slots[i];
+            slot.algorithmPending = false;
+            if (slot.algorithm == algorithm)
+                continue;
+            if (!isListedActive[i] || algSwitchMode == AlgSwitchMode::Instant)
+                setVoiceAlgorithm(i, algorithm);
+            else if (algSwitchMode == AlgSwitchMode::Crossfade)
+                slot.algorithmPending = true;
+            // NewNotes: the voice keeps its routing until startVoice gives it a note
+        }
+    }
+
     AlgSpace algSpace;
     int algIndex;
+    SineMode sineMode = SineMode::Polynomial;
+    MatrixAlgorithm matrixAlgorithm; // the user routing, read by every voice in matrix mode
+    bool matrixMode = false;
+    AlgSwitchMode algSwitchMode = AlgSwitchMode::Crossfade;
     float sampleRate;
 };
@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    VoiceWorkerPool.cpp
+
+  ==============================================================================
+*/
+
+#include "VoiceWorkerPool.h"
+#include <thread>
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+namespace
+{
+    // How long a worker keeps spinning for the next job after a block before it parks. Jobs of
+    // one block arrive within this; the next block is waited for asleep
+    constexpr double spinSeconds = 5.0e-6;
+}
+
+VoiceWorkerPool::VoiceWorkerPool(JobFunction function_, void* context_)
+    : function(function_), context(context_)
+{
+    jassert(function != nullptr);
+}
+
+VoiceWorkerPool::~VoiceWorkerPool()
+{
+    cancelPendingUpdate();
+    stop();
+}
+
+void VoiceWorkerPool::prepare(int samplesPerBlock, double sampleRate)
+{
+    // The workers' real-time scheduling depends on the block duration, so they restart with it
+    stop();
+    maxSpawnable = juce::jlimit(0, maxWorkers, juce::SystemStats::getNumCpus() - 1);
+    options = juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime(juce::jmax(1, samplesPerBlock), sampleRate);
+    prepared = true;
+    cancelPendingUpdate();
+    spawnWorkers();
+}
+
+void VoiceWorkerPool::spawnWorkers()
+{
+    if (!prepared)
+        return;
+    const int target = juce::jmin(maxSpawnable, numRequested.load(std::memory_order_relaxed));
+    for (int i = getNumWorkers(); i < target; ++i)
+    {
+        auto& worker = workers[size_t(i)];
+        worker = std::make_unique<Worker>(*this, i);
+        if (!worker->startRealtimeThread(options))
+            worker->startThread(juce::Thread::Priority::highest);
+        numSpawned.store(i + 1, std::memory_order_release);
+    }
+}
+
+void VoiceWorkerPool::stop()
+{
+    const int numWorkers = getNumWorkers();
+    numSpawned.store(0, std::memory_order_release);
+    for (int i = 0; i < numWorkers; ++i)
+        workers[size_t(i)]->signalThreadShouldExit();
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers[size_t(i)]->wakeUp.signal();
+        workers[size_t(i)]->stopThread(1000);
+        workers[size_t(i)].reset();
+    }
+    prepared = false;
+}
+
+void VoiceWorkerPool::setNumActiveWorkers(int numActive)
+{
+    numActive = juce::jlimit(0, maxWorkers, numActive);
+    numRequested.store(numActive, std::memory_order_relaxed);
+    if (prepared && numActive > getNumWorkers() && getNumWorkers() < maxSpawnable)
+        triggerAsyncUpdate();
+}
+
+void VoiceWorkerPool::run(int numJobs)
+{
+    jassert(numJobs >= 0 && numJobs <= 0xffff);
+    if (numJobs == 0)
+        return;
+
+    jobsDone.store(0, std::memory_order_relaxed);
+    ++generation;
+    // Publishing the ticket hands the job data to the workers. Sequentially consistent,
+    // paired with the sleep announcement in Worker::run, so a sleeping worker is never missed
+    ticket.store((uint64_t(generation) << 32) | (uint64_t(numJobs) << 16), std::memory_order_seq_cst);
+
+    if (numSleeping.load(std::memory_order_seq_cst) > 0)
+    {
+        const int numActive = getNumActiveWorkers();
+        for (int i = 0; i < numActive; ++i)
+            workers[size_t(i)]->wakeUp.signal();
+    }
+
+    work(generation);
+
+    // Barrier: jobs claimed by workers may still be running
+    while (jobsDone.load(std::memory_order_acquire) < numJobs)
+        pause();
+}
+
+void VoiceWorkerPool::work(uint32_t gen)
+{
+    uint64_t current = ticket.load(std::memory_order_acquire);
+    while (generationOf(current) == gen && indexOf(current) < countOf(current))
+    {
+        if (ticket.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            function(context, indexOf(current));
+            jobsDone.fetch_add(1, std::memory_order_release);
+            current = ticket.load(std::memory_order_acquire);
+        }
+    }
+}
+
+void VoiceWorkerPool::pause()
+{
+   #if JUCE_INTEL
+    _mm_pause();
+   #elif JUCE_ARM && (JUCE_GCC || JUCE_CLANG)
+    __asm__ __volatile__ ("yield");
+   #else
+    std::this_thread::yield();
+   #endif
+}
+
+//==============================================================================
+VoiceWorkerPool::Worker::Worker(VoiceWorkerPool& pool_, int index_)
+    : juce::Thread("Voice worker " + juce::String(index_ + 1)), pool(pool_), index(index_)
+{
+}
+
+void VoiceWorkerPool::Worker::run()
+{
+    const auto spinTicks = juce::int64(spinSeconds * double(juce::Time::getHighResolutionTicksPerSecond()));
+    uint32_t lastGeneration = generationOf(pool.ticket.load(std::memory_order_acquire));
+    auto spinEnd = juce::Time::getHighResolutionTicks() + spinTicks;
+    while (!threadShouldExit())
+    {
+        const bool active = index < pool.getNumActiveWorkers();
+        const uint32_t gen = generationOf(pool.ticket.load(std::memory_order_acquire));
+        if (gen != lastGeneration)
+        {
+            lastGeneration = gen;
+            if (active)
+            {
+                pool.work(gen);
+                spinEnd = juce::Time::getHighResolutionTicks() + spinTicks;
+                continue;
+            }
+        }
+
+        if (active && juce::Time::getHighResolutionTicks() < spinEnd)
+        {
+            pause();
+            continue;
+        }
+        // Announce the sleep before the final check, so run() either sees us
+        // sleeping and signals, or we see its new generation. Parked until then:
+        // run(), stop() and nothing else wake a worker
+        pool.numSleeping.fetch_add(1, std::memory_order_seq_cst);
+        if (generationOf(pool.ticket.load(std::memory_order_seq_cst)) == lastGeneration)
+            wakeUp.wait(-1);
+        pool.numSleeping.fetch_sub(1, std::memory_order_acq_rel);
+        spinEnd = juce::Time::getHighResolutionTicks() + spinTicks;
+    }
+}
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    VoiceWorkerPool.h
+
+    A small pool of pre-spawned real-time threads that help the audio thread
+    work through a list of independent jobs within one block.
+
+    Jobs are claimed through a single atomic ticket holding the generation,
+    the job count and the next job index, so a worker can never pick up a job
+    from a block it was not woken for. The audio thread claims jobs too, then
+    spins until every job of the block has finished. Workers spin for a few
+    microseconds after a block, then park on an event until the next one.
+
+    Only as many threads exist as have been asked for: prepare() spawns the
+    requested number, and a later request for more spawns the rest on the
+    message thread, while the audio thread carries on with the workers it has.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+
+class VoiceWorkerPool : private juce::AsyncUpdater
+{
+public:
+    using JobFunction = void (*)(void* context, int jobIndex);
+
+    /// Largest number of helper threads the pool spawns.
+    static constexpr int maxWorkers = 7;
+
+    VoiceWorkerPool(JobFunction function, void* context);
+    ~VoiceWorkerPool() override;
+
+    /*
+    prepare (re)spawns the workers setNumActiveWorkers asked for, never more than the
+    machine can run next to the audio thread. Not real-time safe: call from prepareToPlay.
+    */
+    void prepare(int samplesPerBlock, double sampleRate);
+    void stop();
+
+    /// Number of spawned helper threads.
+    int getNumWorkers() const { return numSpawned.load(std::memory_order_acquire); }
+
+    /// How many workers take part in run(). Real-time safe: workers that do not exist yet are
+    /// spawned asynchronously on the message thread and join once they are running.
+    void setNumActiveWorkers(int numActive);
+    int getNumActiveWorkers() const { return juce::jmin(numRequested.load(std::memory_order_relaxed), getNumWorkers()); }
+
+    /*
+    run executes jobs 0 .. numJobs - 1 across the audio thread and the active workers and
+    returns once all of them have finished. Jobs run in no particular order or thread;
+    anything they write must be private to the job.
+    */
+    void run(int numJobs);
+
+private:
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker(VoiceWorkerPool& pool, int index);
+        void run() override;
+        juce::WaitableEvent wakeUp;
+
+    private:
+        VoiceWorkerPool& pool;
+        const int index;
+    };
+
+    // ticket layout: generation (32 bits) | job count (16 bits) | next job index (16 bits)
+    static uint32_t generationOf(uint64_t ticket) { return uint32_t(ticket >> 32); }
+    static int countOf(uint64_t ticket) { return int((ticket >> 16) & 0xffff); }
+    static int indexOf(uint64_t ticket) { return int(ticket & 0xffff); }
+
+    void work(uint32_t generation);
+    static void pause();
+    // Spawns workers up to the requested number. Message thread only.
+    void spawnWorkers();
+    void handleAsyncUpdate() override { spawnWorkers(); }
+
+    const JobFunction function;
+    void* const context;
+    // Worker i exists once numSpawned > i; the array never moves, so the audio thread can read it meanwhile
+    std::array<std::unique_ptr<Worker>, maxWorkers> workers;
+    std::atomic<int> numSpawned { 0 };
+    std::atomic<int> numRequested { 0 };
+    int maxSpawnable = 0;
+    juce::Thread::RealtimeOptions options;
+    bool prepared = false;
+    std::atomic<uint64_t> ticket { 0 };
+    std::atomic<int> jobsDone { 0 };
+    std::atomic<int> numSleeping { 0 };
+    uint32_t generation = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(VoiceWorkerPool)
+};
@@ -9,7 +9,8 @@
 #include "BitCrusherNode.h"
 
 //==============================================================================
-BitCrusherNode::BitCrusherNode()
+template <typename SampleType>
+BitCrusherNode<SampleType>::BitCrusherNode()
 {
     // Initialize with default parameters
     bitDepth = 16.0f;
@@ -22,7 +23,8 @@ BitCrusherNode::BitCrusherNode()
 }
 
 //==============================================================================
-void BitCrusherNode::prepare(const juce::dsp::ProcessSpec& spec)
+template <typename SampleType>
+void BitCrusherNode<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
 {
     currentSampleRate = spec.sampleRate;
     
@@ -30,32 +32,44 @@ void BitCrusherNode::prepare(const juce::dsp::ProcessSpec& spec)
     reset();
 }
 
-void BitCrusherNode::reset()
+template <typename SampleType>
+void BitCrusherNode<SampleType>::reset()
 {
     // Clear sample and hold state
     holdValue.fill(0.0f);
     sampleCounter.fill(0);
 }
 
+template <typename SampleType>
+void BitCrusherNode<SampleType>::leaveMono()
+{
+    holdValue.fill(holdValue[0]);
+    sampleCounter.fill(sampleCounter[0]);
+}
+
 //==============================================================================
-void BitCrusherNode::setBitDepth(float depth)
+template <typename SampleType>
+void BitCrusherNode<SampleType>::setBitDepth(float depth)
 {
     bitDepth = juce::jlimit(1.0f, 16.0f, depth);
 }
 
-void BitCrusherNode::setSampleRateReduction(float reduction)
+template <typename SampleType>
+void BitCrusherNode<SampleType>::setSampleRateReduction(float reduction)
 {
     sampleRateReduction = juce::jlimit(1.0f, 50.0f, reduction);
 }
 
-void BitCrusherNode::setMix(float mixValue)
+template <typename SampleType>
+void BitCrusherNode<SampleType>::setMix(float mixValue)
 {
     mix = juce::jlimit(0.0f, 1.0f, mixValue);
 }
 
 //==============================================================================
-template<typename ProcessContext>
-void BitCrusherNode::process(const ProcessContext& context) noexcept
+template <typename SampleType>
+template <typename ProcessContext>
+void BitCrusherNode<SampleType>::process(const ProcessContext& context) noexcept
 {
     // Handle bypassed state
     if (context.isBypassed)
@@ -100,12 +114,12 @@ void BitCrusherNode::process(const ProcessContext& context) noexcept
             if (bitDepth < 16.0f)
             {
                 float levels = std::pow(2.0f, bitDepth);
-                float quantized = std::floor(channelData[sample] * levels + 0.5f) / levels;
+                SampleType quantized = std::floor(channelData[sample] * levels + 0.5f) / levels;
                 channelData[sample] = quantized;
             }
 
             // Apply mix
-            float drySignal = (context.usesSeparateInputAndOutputBlocks()) 
+            SampleType drySignal = (context.usesSeparateInputAndOutputBlocks()) 
                 ? inputBlock.getChannelPointer(channel)[sample] 
                 : channelData[sample];
                 
@@ -114,6 +128,10 @@ void BitCrusherNode::process(const ProcessContext& context) noexcept
     }
 }
 
-// Explicit template instantiations for common ProcessContext types
-template void BitCrusherNode::process<juce::dsp::ProcessContextReplacing<float>>(const juce::dsp::ProcessContextReplacing<float>&) noexcept;
-template void BitCrusherNode::process<juce::dsp::ProcessContextNonReplacing<float>>(const juce::dsp::ProcessContextNonReplacing<float>&) noexcept;
+// Explicit template instantiations for both sample types and the common ProcessContext types
+template class BitCrusherNode<float>;
+template class BitCrusherNode<double>;
+template void BitCrusherNode<float>::process<juce::dsp::ProcessContextReplacing<float>>(const juce::dsp::ProcessContextReplacing<float>&) noexcept;
+template void BitCrusherNode<float>::process<juce::dsp::ProcessContextNonReplacing<float>>(const juce::dsp::ProcessContextNonReplacing<float>&) noexcept;
+template void BitCrusherNode<double>::process<juce::dsp::ProcessContextReplacing<double>>(const juce::dsp::ProcessContextReplacing<double>&) noexcept;
+template void BitCrusherNode<double>::process<juce::dsp::ProcessContextNonReplacing<double>>(const juce::dsp::ProcessContextNonReplacing<double>&) noexcept;
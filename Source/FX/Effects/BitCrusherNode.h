@@ -19,7 +19,9 @@
     
     This class provides bit depth reduction and sample rate downsampling
     while maintaining compatibility with JUCE's DSP framework.
+    SampleType is float or double, for the two processing precisions.
 */
+template <typename SampleType>
 class BitCrusherNode
 {
 public:
@@ -34,6 +36,10 @@ public:
     /** Resets the processor's internal state. */
     void reset();
 
+    /** Called before processing more than one channel again after processing channel 0
+        alone: the other channels' state stopped then and is stale. They carry on from channel 0's. */
+    void leaveMono();
+
     /** Processes audio data using the ProcessContext interface. */
     template<typename ProcessContext>
     void process(const ProcessContext& context) noexcept;
@@ -55,7 +61,7 @@ private:
     float mix = 0.5f;
     
     // Sample and hold state for each channel
-    std::array<float, 8> holdValue{};  // Support up to 8 channels
+    std::array<SampleType, 8> holdValue{};  // Support up to 8 channels
     std::array<int, 8> sampleCounter{};
     
     double currentSampleRate = 44100.0;
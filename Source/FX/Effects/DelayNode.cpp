@@ -9,7 +9,8 @@
 #include "DelayNode.h"
 
 //==============================================================================
-DelayNode::DelayNode()
+template <typename SampleType>
+DelayNode<SampleType>::DelayNode()
 {
     // Initialize with default parameters
     delayTimeMs = 250.0f;
@@ -19,7 +20,8 @@ DelayNode::DelayNode()
 }
 
 //==============================================================================
-void DelayNode::prepare(const juce::dsp::ProcessSpec& spec)
+template <typename SampleType>
+void DelayNode<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
 {
     currentSampleRate = spec.sampleRate;
     
@@ -44,7 +46,8 @@ void DelayNode::prepare(const juce::dsp::ProcessSpec& spec)
     reset();
 }
 
-void DelayNode::reset()
+template <typename SampleType>
+void DelayNode<SampleType>::reset()
 {
     // Clear delay lines
     for (auto& delayLine : delayLines)
@@ -59,41 +62,74 @@ void DelayNode::reset()
     }
 }
 
+template <typename SampleType>
+void DelayNode<SampleType>::leaveMono()
+{
+    // DelayLine and IIR::Filter have no state to copy from channel 0, so the echoes build up again
+    for (size_t channel = 1; channel < delayLines.size(); ++channel)
+    {
+        delayLines[channel].reset();
+        lowPassFilters[channel].reset();
+    }
+}
+
 //==============================================================================
-void DelayNode::setDelayTime(float timeMs)
+template <typename SampleType>
+void DelayNode<SampleType>::setDelayTime(float timeMs)
 {
     delayTimeMs = juce::jlimit(0.0f, 2000.0f, timeMs);
     updateDelayTime();
 }
 
-void DelayNode::setFeedback(float feedbackAmount)
+template <typename SampleType>
+void DelayNode<SampleType>::setFeedback(float feedbackAmount)
 {
     feedback = juce::jlimit(0.0f, 0.95f, feedbackAmount);
 }
 
-void DelayNode::setMix(float mixValue)
+template <typename SampleType>
+void DelayNode<SampleType>::setMix(float mixValue)
 {
     mix = juce::jlimit(0.0f, 1.0f, mixValue);
 }
 
-void DelayNode::setLowPassCutoff(float cutoffHz)
+template <typename SampleType>
+void DelayNode<SampleType>::setLowPassCutoff(float cutoffHz)
 {
     lowPassCutoff = juce::jlimit(200.0f, 20000.0f, cutoffHz);
     updateLowPassFilter();
 }
 
 //==============================================================================
-void DelayNode::updateDelayTime()
+template <typename SampleType>
+double DelayNode<SampleType>::getTailLengthSeconds(float timeMs, float feedbackAmount, float mixValue, float threshold)
+{
+    if (mixValue <= 0.0f)
+        return 0.0;
+
+    // Echo n leaves at mix * feedback^(n - 1), one delay time after the one before
+    const double delaySeconds = juce::jlimit(0.0f, 2000.0f, timeMs) / 1000.0;
+    const double loopGain = juce::jlimit(0.0f, 0.95f, feedbackAmount);
+    double echoes = 1.0;
+    if (loopGain > 0.0 && threshold < mixValue)
+        echoes += std::log(threshold / mixValue) / std::log(loopGain);
+    return delaySeconds * echoes;
+}
+
+//==============================================================================
+template <typename SampleType>
+void DelayNode<SampleType>::updateDelayTime()
 {
     delayTimeInSamples = (delayTimeMs / 1000.0f) * static_cast<float>(currentSampleRate);
     delayTimeInSamples = juce::jlimit(0.0f, static_cast<float>(maxDelayInSamples), delayTimeInSamples);
 }
 
-void DelayNode::updateLowPassFilter()
+template <typename SampleType>
+void DelayNode<SampleType>::updateLowPassFilter()
 {
     if (currentSampleRate > 0.0)
     {
-        auto coefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(
+        auto coefficients = juce::dsp::IIR::Coefficients<SampleType>::makeLowPass(
             currentSampleRate, lowPassCutoff);
         
         for (auto& filter : lowPassFilters)
@@ -104,8 +140,9 @@ void DelayNode::updateLowPassFilter()
 }
 
 //==============================================================================
-template<typename ProcessContext>
-void DelayNode::process(const ProcessContext& context) noexcept
+template <typename SampleType>
+template <typename ProcessContext>
+void DelayNode<SampleType>::process(const ProcessContext& context) noexcept
 {
     // Handle bypassed state
     if (context.isBypassed)
@@ -135,13 +172,13 @@ void DelayNode::process(const ProcessContext& context) noexcept
         for (size_t sample = 0; sample < numSamples; ++sample)
         {
             // Get delayed sample
-            float delayedSample = delayLines[channel].popSample(0, delayTimeInSamples, true);
+            SampleType delayedSample = delayLines[channel].popSample(0, delayTimeInSamples, true);
             
             // Apply low-pass filter to feedback
-            float filteredFeedback = lowPassFilters[channel].processSample(delayedSample);
+            SampleType filteredFeedback = lowPassFilters[channel].processSample(delayedSample);
             
             // Calculate input to delay line (input + filtered feedback)
-            float delayInput = inputData[sample] + (filteredFeedback * feedback);
+            SampleType delayInput = inputData[sample] + (filteredFeedback * feedback);
             
             // Push new sample to delay line
             delayLines[channel].pushSample(0, delayInput);
@@ -152,6 +189,10 @@ void DelayNode::process(const ProcessContext& context) noexcept
     }
 }
 
-// Explicit template instantiations for common ProcessContext types
-template void DelayNode::process<juce::dsp::ProcessContextReplacing<float>>(const juce::dsp::ProcessContextReplacing<float>&) noexcept;
-template void DelayNode::process<juce::dsp::ProcessContextNonReplacing<float>>(const juce::dsp::ProcessContextNonReplacing<float>&) noexcept;
+// Explicit template instantiations for both sample types and the common ProcessContext types
+template class DelayNode<float>;
+template class DelayNode<double>;
+template void DelayNode<float>::process<juce::dsp::ProcessContextReplacing<float>>(const juce::dsp::ProcessContextReplacing<float>&) noexcept;
+template void DelayNode<float>::process<juce::dsp::ProcessContextNonReplacing<float>>(const juce::dsp::ProcessContextNonReplacing<float>&) noexcept;
+template void DelayNode<double>::process<juce::dsp::ProcessContextReplacing<double>>(const juce::dsp::ProcessContextReplacing<double>&) noexcept;
+template void DelayNode<double>::process<juce::dsp::ProcessContextNonReplacing<double>>(const juce::dsp::ProcessContextNonReplacing<double>&) noexcept;
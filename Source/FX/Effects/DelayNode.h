@@ -18,7 +18,9 @@
     
     This class provides variable delay time, feedback control, and low-pass filtering
     while maintaining compatibility with JUCE's DSP framework.
+    SampleType is float or double, for the two processing precisions.
 */
+template <typename SampleType>
 class DelayNode
 {
 public:
@@ -33,6 +35,10 @@ public:
     /** Resets the processor's internal state. */
     void reset();
 
+    /** Called before processing more than one channel again after processing channel 0
+        alone: the other channels' state stopped then and is stale. They start empty. */
+    void leaveMono();
+
     /** Processes audio data using the ProcessContext interface. */
     template<typename ProcessContext>
     void process(const ProcessContext& context) noexcept;
@@ -50,13 +56,18 @@ public:
     /** Sets the low-pass filter cutoff frequency for feedback (200-20000Hz). */
     void setLowPassCutoff(float cutoffHz);
 
+    //==============================================================================
+    /** Time for the echoes to fall below threshold (a gain) after the input stops,
+        for the given settings. The feedback filter only shortens it. */
+    static double getTailLengthSeconds(float timeMs, float feedbackAmount, float mixValue, float threshold);
+
 private:
     //==============================================================================
     static constexpr int maxDelayInSamples = 96000; // 2 seconds at 48kHz
     static constexpr int maxChannels = 8;
     
-    std::array<juce::dsp::DelayLine<float>, maxChannels> delayLines;
-    std::array<juce::dsp::IIR::Filter<float>, maxChannels> lowPassFilters;
+    std::array<juce::dsp::DelayLine<SampleType>, maxChannels> delayLines;
+    std::array<juce::dsp::IIR::Filter<SampleType>, maxChannels> lowPassFilters;
     
     float delayTimeMs = 250.0f;
     float delayTimeInSamples = 0.0f;
@@ -31,6 +31,9 @@ void ReverbNode::prepare(const juce::dsp::ProcessSpec& spec)
     
     // Initialize the reverb with the sample rate
     reverb.setSampleRate(currentSampleRate);
+
+    // Only the double-precision path converts through this
+    conversionBuffer.setSize(2, juce::jmax(1, static_cast<int>(spec.maximumBlockSize)));
     
     // Reset the reverb state
     reverb.reset();
@@ -95,6 +98,22 @@ void ReverbNode::setMix(float mix)
     updateInternalReverb();
 }
 
+//==============================================================================
+double ReverbNode::getTailLengthSeconds(float roomSize, float mix, bool frozen, float threshold)
+{
+    if (mix <= 0.0f)
+        return 0.0;
+    if (frozen)
+        return std::numeric_limits<double>::infinity();
+
+    // juce::Reverb's combs feed back roomSize * 0.28 + 0.7 every loop at DC, where damping does not
+    // act; the longest comb sets the decay. The all-passes feed back 0.5 and add their own ring.
+    const double combGain = juce::jlimit(0.0f, 1.0f, roomSize) * 0.28 + 0.7;
+    const double combLoops = std::log(threshold) / std::log(combGain);
+    const double allPassLoops = std::log(threshold) / std::log(0.5);
+    return combLoops * (1617 + 23) / 44100.0 + allPassLoops * (556 + 441 + 341 + 225) / 44100.0;
+}
+
 //==============================================================================
 void ReverbNode::updateInternalReverb()
 {
@@ -50,21 +50,45 @@ public:
         auto& audioBlock = context.getOutputBlock();
         auto numChannels = audioBlock.getNumChannels();
         auto numSamples = audioBlock.getNumSamples();
+        if (numChannels == 0)
+            return;
 
-        // Process based on channel configuration
-        if (numChannels == 1)
+        using SampleType = typename ProcessContext::SampleType;
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            processChannels(audioBlock.getChannelPointer(0),
+                            numChannels >= 2 ? audioBlock.getChannelPointer(1) : nullptr,
+                            static_cast<int>(numSamples));
+        }
+        else
         {
-            // Mono processing
-            auto* monoData = audioBlock.getChannelPointer(0);
-            reverb.processMono(monoData, static_cast<int>(numSamples));
+            // juce::Reverb is float-only, so a double block goes through it converted, a scratch-full at a time
+            const size_t numScratchChannels = juce::jmin(numChannels, size_t(2));
+            for (size_t start = 0; start < numSamples; start += size_t(conversionBuffer.getNumSamples()))
+            {
+                const size_t length = juce::jmin(numSamples - start, size_t(conversionBuffer.getNumSamples()));
+                for (size_t channel = 0; channel < numScratchChannels; ++channel)
+                {
+                    const SampleType* source = audioBlock.getChannelPointer(channel) + start;
+                    float* scratch = conversionBuffer.getWritePointer(int(channel));
+                    for (size_t i = 0; i < length; ++i)
+                        scratch[i] = static_cast<float>(source[i]);
+                }
+                processChannels(conversionBuffer.getWritePointer(0),
+                                numScratchChannels == 2 ? conversionBuffer.getWritePointer(1) : nullptr,
+                                static_cast<int>(length));
+                for (size_t channel = 0; channel < numScratchChannels; ++channel)
+                {
+                    SampleType* destination = audioBlock.getChannelPointer(channel) + start;
+                    const float* scratch = conversionBuffer.getReadPointer(int(channel));
+                    for (size_t i = 0; i < length; ++i)
+                        destination[i] = static_cast<SampleType>(scratch[i]);
+                }
+            }
         }
-        else if (numChannels >= 2)
+
+        if (numChannels >= 2)
         {
-            // Stereo processing
-            auto* leftData = audioBlock.getChannelPointer(0);
-            auto* rightData = audioBlock.getChannelPointer(1);
-            reverb.processStereo(leftData, rightData, static_cast<int>(numSamples));
-            
             // Handle any additional output channels (copy from stereo if needed)
             for (int channel = 2; channel < numChannels; ++channel)
             {
@@ -94,14 +118,33 @@ public:
     /** Convenience method to set wet/dry mix (0.0 = dry, 1.0 = wet). */
     void setMix(float mix);
 
+    //==============================================================================
+    /** Time for the reverb to fall below threshold (a gain) after the input stops,
+        for the given settings. Infinite while frozen. */
+    static double getTailLengthSeconds(float roomSize, float mix, bool frozen, float threshold);
+
+    /** Longest delay inside juce::Reverb (last comb, stereo spread and all-pass chain) in seconds.
+        The tunings are fixed at 44.1kHz and scaled with the sample rate, so this holds at any rate. */
+    static constexpr double longestDelaySeconds = (1617 + 23 + 556 + 441 + 341 + 225) / 44100.0;
+
 private:
     //==============================================================================
     juce::Reverb reverb;
     juce::Reverb::Parameters currentParams;
     double currentSampleRate = 44100.0;
+    juce::AudioBuffer<float> conversionBuffer { 2, 512 };  // float copy of a double block, sized in prepare
     
     /** Updates the internal reverb with current parameters. */
     void updateInternalReverb();
+
+    /** Runs the reverb in place on one channel (right is null) or a stereo pair. */
+    void processChannels(float* left, float* right, int numSamples)
+    {
+        if (right == nullptr)
+            reverb.processMono(left, numSamples);
+        else
+            reverb.processStereo(left, right, numSamples);
+    }
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReverbNode)
 };
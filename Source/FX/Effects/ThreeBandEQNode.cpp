@@ -9,7 +9,8 @@
 #include "ThreeBandEQNode.h"
 
 //==============================================================================
-ThreeBandEQNode::ThreeBandEQNode()
+template <typename SampleType>
+ThreeBandEQNode<SampleType>::ThreeBandEQNode()
 {
     // Initialize with default parameters
     lowGain = 0.0f;
@@ -22,7 +23,8 @@ ThreeBandEQNode::ThreeBandEQNode()
 }
 
 //==============================================================================
-void ThreeBandEQNode::prepare(const juce::dsp::ProcessSpec& spec)
+template <typename SampleType>
+void ThreeBandEQNode<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
 {
     currentSampleRate = spec.sampleRate;
     
@@ -51,7 +53,8 @@ void ThreeBandEQNode::prepare(const juce::dsp::ProcessSpec& spec)
     reset();
 }
 
-void ThreeBandEQNode::reset()
+template <typename SampleType>
+void ThreeBandEQNode<SampleType>::reset()
 {
     // Reset all filters
     for (auto& filter : lowShelfFilters)
@@ -70,55 +73,74 @@ void ThreeBandEQNode::reset()
     }
 }
 
+template <typename SampleType>
+void ThreeBandEQNode<SampleType>::leaveMono()
+{
+    for (size_t channel = 1; channel < size_t(maxChannels); ++channel)
+    {
+        lowShelfFilters[channel].reset();
+        midFilters[channel].reset();
+        highShelfFilters[channel].reset();
+    }
+}
+
 //==============================================================================
-void ThreeBandEQNode::setLowGain(float gainDb)
+template <typename SampleType>
+void ThreeBandEQNode<SampleType>::setLowGain(float gainDb)
 {
     lowGain = juce::jlimit(-12.0f, 12.0f, gainDb);
     updateLowShelfFilter();
 }
 
-void ThreeBandEQNode::setLowFreq(float freqHz)
+template <typename SampleType>
+void ThreeBandEQNode<SampleType>::setLowFreq(float freqHz)
 {
     lowFreq = juce::jlimit(20.0f, 500.0f, freqHz);
     updateLowShelfFilter();
 }
 
-void ThreeBandEQNode::setMidGain(float gainDb)
+template <typename SampleType>
+void ThreeBandEQNode<SampleType>::setMidGain(float gainDb)
 {
     midGain = juce::jlimit(-12.0f, 12.0f, gainDb);
     updateMidFilter();
 }
 
-void ThreeBandEQNode::setMidFreq(float freqHz)
+template <typename SampleType>
+void ThreeBandEQNode<SampleType>::setMidFreq(float freqHz)
 {
     midFreq = juce::jlimit(200.0f, 5000.0f, freqHz);
     updateMidFilter();
 }
 
-void ThreeBandEQNode::setMidQ(float qValue)
+template <typename SampleType>
+void ThreeBandEQNode<SampleType>::setMidQ(float qValue)
 {
     midQ = juce::jlimit(0.1f, 10.0f, qValue);
     updateMidFilter();
 }
 
-void ThreeBandEQNode::setHighGain(float gainDb)
+template <typename SampleType>
+void ThreeBandEQNode<SampleType>::setHighGain(float gainDb)
 {
     highGain = juce::jlimit(-12.0f, 12.0f, gainDb);
     updateHighShelfFilter();
 }
 
-void ThreeBandEQNode::setHighFreq(float freqHz)
+template <typename SampleType>
+void ThreeBandEQNode<SampleType>::setHighFreq(float freqHz)
 {
     highFreq = juce::jlimit(2000.0f, 20000.0f, freqHz);
     updateHighShelfFilter();
 }
 
 //==============================================================================
-void ThreeBandEQNode::updateLowShelfFilter()
+template <typename SampleType>
+void ThreeBandEQNode<SampleType>::updateLowShelfFilter()
 {
     if (currentSampleRate > 0.0)
     {
-        auto coefficients = juce::dsp::IIR::Coefficients<float>::makeLowShelf(
+        auto coefficients = juce::dsp::IIR::Coefficients<SampleType>::makeLowShelf(
             currentSampleRate, lowFreq, 0.707f, juce::Decibels::decibelsToGain(lowGain));
         
         for (auto& filter : lowShelfFilters)
@@ -128,11 +150,12 @@ void ThreeBandEQNode::updateLowShelfFilter()
     }
 }
 
-void ThreeBandEQNode::updateMidFilter()
+template <typename SampleType>
+void ThreeBandEQNode<SampleType>::updateMidFilter()
 {
     if (currentSampleRate > 0.0)
     {
-        auto coefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(
+        auto coefficients = juce::dsp::IIR::Coefficients<SampleType>::makePeakFilter(
             currentSampleRate, midFreq, midQ, juce::Decibels::decibelsToGain(midGain));
         
         for (auto& filter : midFilters)
@@ -142,11 +165,12 @@ void ThreeBandEQNode::updateMidFilter()
     }
 }
 
-void ThreeBandEQNode::updateHighShelfFilter()
+template <typename SampleType>
+void ThreeBandEQNode<SampleType>::updateHighShelfFilter()
 {
     if (currentSampleRate > 0.0)
     {
-        auto coefficients = juce::dsp::IIR::Coefficients<float>::makeHighShelf(
+        auto coefficients = juce::dsp::IIR::Coefficients<SampleType>::makeHighShelf(
             currentSampleRate, highFreq, 0.707f, juce::Decibels::decibelsToGain(highGain));
         
         for (auto& filter : highShelfFilters)
@@ -157,8 +181,9 @@ void ThreeBandEQNode::updateHighShelfFilter()
 }
 
 //==============================================================================
-template<typename ProcessContext>
-void ThreeBandEQNode::process(const ProcessContext& context) noexcept
+template <typename SampleType>
+template <typename ProcessContext>
+void ThreeBandEQNode<SampleType>::process(const ProcessContext& context) noexcept
 {
     // Handle bypassed state
     if (context.isBypassed)
@@ -184,10 +209,10 @@ void ThreeBandEQNode::process(const ProcessContext& context) noexcept
         
         for (size_t sample = 0; sample < numSamples; ++sample)
         {
-            float inputSample = channelData[sample];
+            SampleType inputSample = channelData[sample];
             
             // Process through each filter stage
-            float processedSample = inputSample;
+            SampleType processedSample = inputSample;
             
             // Low shelf filter
             processedSample = lowShelfFilters[channel].processSample(processedSample);
@@ -203,6 +228,10 @@ void ThreeBandEQNode::process(const ProcessContext& context) noexcept
     }
 }
 
-// Explicit template instantiations for common ProcessContext types
-template void ThreeBandEQNode::process<juce::dsp::ProcessContextReplacing<float>>(const juce::dsp::ProcessContextReplacing<float>&) noexcept;
-template void ThreeBandEQNode::process<juce::dsp::ProcessContextNonReplacing<float>>(const juce::dsp::ProcessContextNonReplacing<float>&) noexcept;
+// Explicit template instantiations for both sample types and the common ProcessContext types
+template class ThreeBandEQNode<float>;
+template class ThreeBandEQNode<double>;
+template void ThreeBandEQNode<float>::process<juce::dsp::ProcessContextReplacing<float>>(const juce::dsp::ProcessContextReplacing<float>&) noexcept;
+template void ThreeBandEQNode<float>::process<juce::dsp::ProcessContextNonReplacing<float>>(const juce::dsp::ProcessContextNonReplacing<float>&) noexcept;
+template void ThreeBandEQNode<double>::process<juce::dsp::ProcessContextReplacing<double>>(const juce::dsp::ProcessContextReplacing<double>&) noexcept;
+template void ThreeBandEQNode<double>::process<juce::dsp::ProcessContextNonReplacing<double>>(const juce::dsp::ProcessContextNonReplacing<double>&) noexcept;
@@ -18,7 +18,9 @@
     
     This class provides low shelf, parametric mid, and high shelf filters
     while maintaining compatibility with JUCE's DSP framework.
+    SampleType is float or double, for the two processing precisions.
 */
+template <typename SampleType>
 class ThreeBandEQNode
 {
 public:
@@ -33,6 +35,10 @@ public:
     /** Resets the processor's internal state. */
     void reset();
 
+    /** Called before processing more than one channel again after processing channel 0
+        alone: the other channels' state stopped then and is stale. They start from silence. */
+    void leaveMono();
+
     /** Processes audio data using the ProcessContext interface. */
     template<typename ProcessContext>
     void process(const ProcessContext& context) noexcept;
@@ -63,9 +69,9 @@ private:
     //==============================================================================
     static constexpr int maxChannels = 8;
     
-    std::array<juce::dsp::IIR::Filter<float>, maxChannels> lowShelfFilters;
-    std::array<juce::dsp::IIR::Filter<float>, maxChannels> midFilters;
-    std::array<juce::dsp::IIR::Filter<float>, maxChannels> highShelfFilters;
+    std::array<juce::dsp::IIR::Filter<SampleType>, maxChannels> lowShelfFilters;
+    std::array<juce::dsp::IIR::Filter<SampleType>, maxChannels> midFilters;
+    std::array<juce::dsp::IIR::Filter<SampleType>, maxChannels> highShelfFilters;
     
     float lowGain = 0.0f;
     float lowFreq = 200.0f;
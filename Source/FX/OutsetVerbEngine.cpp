@@ -14,22 +14,57 @@
 OutsetVerbEngine::OutsetVerbEngine(juce::AudioProcessorValueTreeState& apvtsRef)
     : apvts(apvtsRef)
 {
+    // Resolve the parameter atomics once so the audio thread never looks up IDs
+    params.bitDepth = apvts.getRawParameterValue("bitDepth");
+    params.sampleRateReduction = apvts.getRawParameterValue("sampleRateReduction");
+    params.bitCrusherMix = apvts.getRawParameterValue("bitCrusherMix");
+    params.delayTime = apvts.getRawParameterValue("delayTime");
+    params.delayFeedback = apvts.getRawParameterValue("delayFeedback");
+    params.delayMix = apvts.getRawParameterValue("delayMix");
+    params.delayLowPassCutoff = apvts.getRawParameterValue("delayLowPassCutoff");
+    params.lowGain = apvts.getRawParameterValue("lowGain");
+    params.lowFreq = apvts.getRawParameterValue("lowFreq");
+    params.midGain = apvts.getRawParameterValue("midGain");
+    params.midFreq = apvts.getRawParameterValue("midFreq");
+    params.midQ = apvts.getRawParameterValue("midQ");
+    params.highGain = apvts.getRawParameterValue("highGain");
+    params.highFreq = apvts.getRawParameterValue("highFreq");
+    params.roomSize = apvts.getRawParameterValue("roomSize");
+    params.damping = apvts.getRawParameterValue("damping");
+    params.width = apvts.getRawParameterValue("width");
+    params.freezeMode = apvts.getRawParameterValue("freezeMode");
+    params.reverbMix = apvts.getRawParameterValue("reverbMix");
+    params.chainSlots[0] = apvts.getRawParameterValue("chainSlot1");
+    params.chainSlots[1] = apvts.getRawParameterValue("chainSlot2");
+    params.chainSlots[2] = apvts.getRawParameterValue("chainSlot3");
+    params.chainSlots[3] = apvts.getRawParameterValue("chainSlot4");
 }
 
 //==============================================================================
-void OutsetVerbEngine::prepare(const juce::dsp::ProcessSpec& spec)
+void OutsetVerbEngine::prepare(const juce::dsp::ProcessSpec& spec, bool doublePrecision_)
 {
-    // Prepare individual effect processors with the given audio specs
-    bitCrusherProcessor.prepare(spec);
-    delayProcessor.prepare(spec);
-    eqProcessor.prepare(spec);
-    reverbProcessor.prepare(spec);
+    doublePrecision = doublePrecision_;
+    ranMono.fill(false);
 
-    // Update parameters to current APVTS values
-    updateChainParameters();
+    // Prepare individual effect processors with the given audio specs; the other precision's set stays idle
+    reverbProcessor.prepare(spec);
+    auto prepareNodes = [&](auto& nodes)
+    {
+        nodes.bitCrusher.prepare(spec);
+        nodes.delay.prepare(spec);
+        nodes.eq.prepare(spec);
+
+        // Update parameters to current APVTS values
+        updateChainParameters(nodes);
+    };
+    if (doublePrecision)
+        prepareNodes(doubleNodes);
+    else
+        prepareNodes(floatNodes);
 }
 
-void OutsetVerbEngine::processBlock(juce::AudioBuffer<float>& buffer)
+template <typename SampleType>
+void OutsetVerbEngine::processBlock(juce::AudioBuffer<SampleType>& buffer, bool monoInput)
 {
     auto numSamples = buffer.getNumSamples();
     
@@ -37,11 +72,23 @@ void OutsetVerbEngine::processBlock(juce::AudioBuffer<float>& buffer)
     if (numSamples == 0)
         return;
 
+    jassert(doublePrecision == (std::is_same_v<SampleType, double>));
+    auto& nodes = getNodes<SampleType>();
+
     // Update parameters from APVTS
-    updateChainParameters();
+    updateChainParameters(nodes);
 
     // Create audio block from buffer for DSP processing
-    juce::dsp::AudioBlock<float> audioBlock(buffer);
+    juce::dsp::AudioBlock<SampleType> audioBlock(buffer);
+
+    // Channel 0 is copied to the rest once, when the signal has to become stereo
+    bool mono = monoInput && buffer.getNumChannels() > 1;
+    auto expandToStereo = [&]
+    {
+        for (int channel = 1; channel < buffer.getNumChannels(); ++channel)
+            buffer.copyFrom(channel, 0, buffer, 0, 0, numSamples);
+        mono = false;
+    };
 
     // Process through effects in the configured order
     for (int slot = 0; slot < 4; ++slot)
@@ -52,20 +99,34 @@ void OutsetVerbEngine::processBlock(juce::AudioBuffer<float>& buffer)
         if (effectType == EffectType::none)
             continue;
 
-        // Create process context for this effect
-        juce::dsp::ProcessContextReplacing<float> context(audioBlock);
+        if (mono && isStereoEffect(effectType))
+            expandToStereo();
+
+        // Create process context for this effect; mono-safe effects see only channel 0 until then
+        auto effectBlock = mono ? audioBlock.getSingleChannelBlock(0) : audioBlock;
+        // A node that ran on channel 0 alone restarts the others' stale state when they come back
+        auto leaveMono = [&](auto& node)
+        {
+            if (!mono && ranMono[size_t(effectType)])
+                node.leaveMono();
+            ranMono[size_t(effectType)] = mono;
+        };
+        juce::dsp::ProcessContextReplacing<SampleType> context(effectBlock);
 
         // Process through the appropriate effect
         switch (effectType)
         {
             case EffectType::bitCrusher:
-                bitCrusherProcessor.process(context);
+                leaveMono(nodes.bitCrusher);
+                nodes.bitCrusher.process(context);
                 break;
             case EffectType::delay:
-                delayProcessor.process(context);
+                leaveMono(nodes.delay);
+                nodes.delay.process(context);
                 break;
             case EffectType::eq:
-                eqProcessor.process(context);
+                leaveMono(nodes.eq);
+                nodes.eq.process(context);
                 break;
             case EffectType::reverb:
                 reverbProcessor.process(context);
@@ -75,58 +136,114 @@ void OutsetVerbEngine::processBlock(juce::AudioBuffer<float>& buffer)
                 break;
         }
     }
+
+    if (mono)
+        expandToStereo();
 }
 
+template void OutsetVerbEngine::processBlock<float>(juce::AudioBuffer<float>&, bool);
+template void OutsetVerbEngine::processBlock<double>(juce::AudioBuffer<double>&, bool);
+
 void OutsetVerbEngine::reset()
 {
-    // Reset individual effect processors
-    bitCrusherProcessor.reset();
-    delayProcessor.reset();
-    eqProcessor.reset();
+    // Reset individual effect processors of the prepared precision
+    auto resetNodes = [](auto& nodes)
+    {
+        nodes.bitCrusher.reset();
+        nodes.delay.reset();
+        nodes.eq.reset();
+    };
+    ranMono.fill(false);
+    if (doublePrecision)
+        resetNodes(doubleNodes);
+    else
+        resetNodes(floatNodes);
     reverbProcessor.reset();
 }
 
+double OutsetVerbEngine::getTailLengthSeconds(float threshold) const
+{
+    // The effects run in series, so their tails add up; the bit crusher and EQ have none to speak of
+    double tail = 0.0;
+    for (auto* slot : params.chainSlots)
+    {
+        switch (static_cast<int>(slot->load()))
+        {
+            case EffectType::delay:
+                tail += DelayNode<float>::getTailLengthSeconds(params.delayTime->load(), params.delayFeedback->load(),
+                                                               params.delayMix->load(), threshold);
+                break;
+            case EffectType::reverb:
+                tail += ReverbNode::getTailLengthSeconds(params.roomSize->load(), params.reverbMix->load(),
+                                                         params.freezeMode->load() > 0.5f, threshold);
+                break;
+            default:
+                break;
+        }
+    }
+    return tail;
+}
+
+double OutsetVerbEngine::getLongestInternalDelaySeconds() const
+{
+    double delaySeconds = 0.0;
+    for (auto* slot : params.chainSlots)
+    {
+        switch (static_cast<int>(slot->load()))
+        {
+            case EffectType::delay:
+                delaySeconds += juce::jlimit(0.0f, 2000.0f, params.delayTime->load()) / 1000.0;
+                break;
+            case EffectType::reverb:
+                delaySeconds += ReverbNode::longestDelaySeconds;
+                break;
+            default:
+                break;
+        }
+    }
+    return delaySeconds;
+}
+
 //==============================================================================
-void OutsetVerbEngine::updateChainParameters()
+template <typename SampleType>
+void OutsetVerbEngine::updateChainParameters(EffectNodes<SampleType>& nodes)
 {
     // Update BitCrusher parameters
-    bitCrusherProcessor.setBitDepth(apvts.getRawParameterValue("bitDepth")->load());
-    bitCrusherProcessor.setSampleRateReduction(apvts.getRawParameterValue("sampleRateReduction")->load());
-    bitCrusherProcessor.setMix(apvts.getRawParameterValue("bitCrusherMix")->load());
+    nodes.bitCrusher.setBitDepth(params.bitDepth->load());
+    nodes.bitCrusher.setSampleRateReduction(params.sampleRateReduction->load());
+    nodes.bitCrusher.setMix(params.bitCrusherMix->load());
 
     // Update Delay parameters
-    delayProcessor.setDelayTime(apvts.getRawParameterValue("delayTime")->load());
-    delayProcessor.setFeedback(apvts.getRawParameterValue("delayFeedback")->load());
-    delayProcessor.setMix(apvts.getRawParameterValue("delayMix")->load());
-    delayProcessor.setLowPassCutoff(apvts.getRawParameterValue("delayLowPassCutoff")->load());
+    nodes.delay.setDelayTime(params.delayTime->load());
+    nodes.delay.setFeedback(params.delayFeedback->load());
+    nodes.delay.setMix(params.delayMix->load());
+    nodes.delay.setLowPassCutoff(params.delayLowPassCutoff->load());
 
     // Update EQ parameters
-    eqProcessor.setLowGain(apvts.getRawParameterValue("lowGain")->load());
-    eqProcessor.setLowFreq(apvts.getRawParameterValue("lowFreq")->load());
-    eqProcessor.setMidGain(apvts.getRawParameterValue("midGain")->load());
-    eqProcessor.setMidFreq(apvts.getRawParameterValue("midFreq")->load());
-    eqProcessor.setMidQ(apvts.getRawParameterValue("midQ")->load());
-    eqProcessor.setHighGain(apvts.getRawParameterValue("highGain")->load());
-    eqProcessor.setHighFreq(apvts.getRawParameterValue("highFreq")->load());
+    nodes.eq.setLowGain(params.lowGain->load());
+    nodes.eq.setLowFreq(params.lowFreq->load());
+    nodes.eq.setMidGain(params.midGain->load());
+    nodes.eq.setMidFreq(params.midFreq->load());
+    nodes.eq.setMidQ(params.midQ->load());
+    nodes.eq.setHighGain(params.highGain->load());
+    nodes.eq.setHighFreq(params.highFreq->load());
 
     // Update Reverb parameters
-    reverbProcessor.setRoomSize(apvts.getRawParameterValue("roomSize")->load());
-    reverbProcessor.setDamping(apvts.getRawParameterValue("damping")->load());
-    reverbProcessor.setWidth(apvts.getRawParameterValue("width")->load());
+    reverbProcessor.setRoomSize(params.roomSize->load());
+    reverbProcessor.setDamping(params.damping->load());
+    reverbProcessor.setWidth(params.width->load());
 
     // Handle freeze mode - convert bool to float
-    bool freezeMode = apvts.getRawParameterValue("freezeMode")->load() > 0.5f;
+    bool freezeMode = params.freezeMode->load() > 0.5f;
     reverbProcessor.setFreezeMode(freezeMode ? 1.0f : 0.0f);
 
     // Handle reverb mix parameter
-    float reverbMixValue = apvts.getRawParameterValue("reverbMix")->load();
+    float reverbMixValue = params.reverbMix->load();
     reverbProcessor.setMix(reverbMixValue);
 
     // Update chain configuration from parameters
-    chainConfiguration[0] = static_cast<int>(apvts.getRawParameterValue("chainSlot1")->load());
-    chainConfiguration[1] = static_cast<int>(apvts.getRawParameterValue("chainSlot2")->load());
-    chainConfiguration[2] = static_cast<int>(apvts.getRawParameterValue("chainSlot3")->load());
-    chainConfiguration[3] = static_cast<int>(apvts.getRawParameterValue("chainSlot4")->load());
+    for (size_t slot = 0; slot < chainConfiguration.size(); ++slot)
+        chainConfiguration[slot] = static_cast<int>(params.chainSlots[slot]->load());
 }
 
 //==============================================================================
@@ -38,14 +38,28 @@ public:
     ~OutsetVerbEngine() = default;
     
     //==============================================================================
-    /** Prepares the audio processing engine with the given specs. */
-    void prepare(const juce::dsp::ProcessSpec& spec);
+    /** Prepares the audio processing engine with the given specs, for float
+        buffers or, with doublePrecision set, for double buffers. */
+    void prepare(const juce::dsp::ProcessSpec& spec, bool doublePrecision = false);
     
-    /** Processes an audio buffer through the effect chain. */
-    void processBlock(juce::AudioBuffer<float>& buffer);
+    /** Processes an audio buffer through the effect chain.
+        With monoInput set, only channel 0 carries signal: the mono-safe effects
+        process that channel alone, and it is copied to the other channels at the
+        first stereo effect or at the end of the chain.
+        SampleType must match the precision the engine was prepared for. */
+    template <typename SampleType>
+    void processBlock(juce::AudioBuffer<SampleType>& buffer, bool monoInput = false);
     
     /** Resets all effect processors. */
     void reset();
+
+    /** Time for the chain's tails to fall below threshold (a gain) after its input stops,
+        from the current parameter values. Safe to call from any thread. */
+    double getTailLengthSeconds(float threshold) const;
+
+    /** Longest time a signal can spend inside the chain before it reaches the output.
+        The output may be silent for this long while a delayed tail is still on its way. */
+    double getLongestInternalDelaySeconds() const;
     
     //==============================================================================
     /** Creates the parameter layout for all Outset-Verb parameters.
@@ -65,21 +79,72 @@ private:
         reverb = 4
     };
     
-    // Individual effect processors
-    BitCrusherNode bitCrusherProcessor;
-    DelayNode delayProcessor;
-    ThreeBandEQNode eqProcessor;
+    /** True for effects whose channels differ even when fed the same signal. */
+    static bool isStereoEffect(int effectType) { return effectType == EffectType::reverb; }
+
+    /** The effect processors that run at the sample type's precision. */
+    template <typename SampleType>
+    struct EffectNodes
+    {
+        BitCrusherNode<SampleType> bitCrusher;
+        DelayNode<SampleType> delay;
+        ThreeBandEQNode<SampleType> eq;
+    };
+
+    // Individual effect processors: one set per precision, of which only the prepared one runs.
+    // juce::Reverb is float-only, so the reverb is shared and converts double blocks.
+    EffectNodes<float> floatNodes;
+    EffectNodes<double> doubleNodes;
     ReverbNode reverbProcessor;
+    bool doublePrecision = false;
+    // Indexed by EffectType: the node processed channel 0 alone last time, see the nodes' leaveMono
+    std::array<bool, 5> ranMono {};
+
+    template <typename SampleType>
+    EffectNodes<SampleType>& getNodes()
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            return floatNodes;
+        else
+            return doubleNodes;
+    }
     
     // Chain configuration - stores which effect is in each position
     std::array<int, 4> chainConfiguration = {0, 0, 0, 0};
     
     // Reference to external APVTS (not owned by this class)
     juce::AudioProcessorValueTreeState& apvts;
+
+    /** Parameter atomics, resolved from apvts once in the constructor. */
+    struct ParameterPointers
+    {
+        std::atomic<float>* bitDepth = nullptr;
+        std::atomic<float>* sampleRateReduction = nullptr;
+        std::atomic<float>* bitCrusherMix = nullptr;
+        std::atomic<float>* delayTime = nullptr;
+        std::atomic<float>* delayFeedback = nullptr;
+        std::atomic<float>* delayMix = nullptr;
+        std::atomic<float>* delayLowPassCutoff = nullptr;
+        std::atomic<float>* lowGain = nullptr;
+        std::atomic<float>* lowFreq = nullptr;
+        std::atomic<float>* midGain = nullptr;
+        std::atomic<float>* midFreq = nullptr;
+        std::atomic<float>* midQ = nullptr;
+        std::atomic<float>* highGain = nullptr;
+        std::atomic<float>* highFreq = nullptr;
+        std::atomic<float>* roomSize = nullptr;
+        std::atomic<float>* damping = nullptr;
+        std::atomic<float>* width = nullptr;
+        std::atomic<float>* freezeMode = nullptr;
+        std::atomic<float>* reverbMix = nullptr;
+        std::array<std::atomic<float>*, 4> chainSlots {};
+    };
+    ParameterPointers params;
     
     //==============================================================================
     /** Updates all effect parameters from APVTS values. */
-    void updateChainParameters();
+    template <typename SampleType>
+    void updateChainParameters(EffectNodes<SampleType>& nodes);
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OutsetVerbEngine)
 };
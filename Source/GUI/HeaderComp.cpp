@@ -14,8 +14,8 @@
 #include "HeaderComp.h"
 
 //==============================================================================
-HeaderComp::HeaderComp(PresetManager& pm) :
-    presetPanel(pm)
+HeaderComp::HeaderComp(PresetManager& pm, TuningManager& tm) :
+    presetPanel(pm), tuningManager(tm)
 {
     // In your constructor, you should add any child components, and
     // initialise any special settings that your component needs.
@@ -28,6 +28,21 @@ HeaderComp::HeaderComp(PresetManager& pm) :
     fxButton.setColour(juce::TextButton::textColourOnId, colors().white);
     fxButton.onClick = [this] { showFXPopup(); };
     addAndMakeVisible(fxButton);
+    // Setup tuning button, lit while a Scala tuning is loaded
+    tuningButton.setButtonText("Tuning");
+    tuningButton.setColour(juce::TextButton::buttonColourId, colors().bg);
+    tuningButton.setColour(juce::TextButton::buttonOnColourId, colors().accent);
+    tuningButton.setColour(juce::TextButton::textColourOffId, colors().white);
+    tuningButton.setColour(juce::TextButton::textColourOnId, colors().white);
+    tuningButton.setToggleState(tuningManager.isMicrotuned(), juce::dontSendNotification);
+    tuningButton.onClick = [this] { showTuningMenu(); };
+    addAndMakeVisible(tuningButton);
+    // Setup modulation meter
+    modulationMeter.setFont(juce::FontOptions(11.0f));
+    modulationMeter.setColour(juce::Label::textColourId, colors().main);
+    modulationMeter.setJustificationType(juce::Justification::centredRight);
+    modulationMeter.setMinimumHorizontalScale(0.7f);
+    addAndMakeVisible(modulationMeter);
 }
 
 HeaderComp::~HeaderComp()
@@ -54,9 +69,25 @@ void HeaderComp::resized()
 
     presetPanel.setBounds(getBounds().withTrimmedRight(width/3));
     
-    // Position FX button in the remaining 1/3 with 10px margins
-    auto fxBounds = bounds.removeFromRight(width/3).reduced(10);
-    fxButton.setBounds(fxBounds);
+    // Tuning and FX buttons share the remaining 1/3, with 10px margins, above the modulation meter
+    auto buttonBounds = bounds.removeFromRight(width/3);
+    modulationMeter.setBounds(buttonBounds.removeFromBottom(juce::jmin(16, height / 4)).withTrimmedRight(10));
+    tuningButton.setBounds(buttonBounds.removeFromLeft(buttonBounds.getWidth() / 2).reduced(10));
+    fxButton.setBounds(buttonBounds.reduced(10));
+}
+
+void HeaderComp::showModulationLoad(const ModulationLoad& load)
+{
+    static constexpr const char* sourceNames[] = { "LFO 1", "LFO 2", "Noise" };
+    juce::StringArray parts;
+    for (size_t s = 0; s < load.routes.size(); ++s)
+    {
+        if (load.routes[s] > 0)
+            parts.add(juce::String(sourceNames[s]) + ": " + juce::String(load.routes[s])
+                      + (load.routes[s] == 1 ? " route, " : " routes, ")
+                      + juce::String(load.microsecondsPerPoint[s], 3) + " us/point");
+    }
+    modulationMeter.setText(parts.joinIntoString("   "), juce::dontSendNotification);
 }
 
 void HeaderComp::showFXPopup()
@@ -66,3 +97,46 @@ void HeaderComp::showFXPopup()
         onFXButtonClicked();
     presetPanel.setBounds(getBounds());
 }
+
+void HeaderComp::showTuningMenu()
+{
+    tuningButton.setToggleState(tuningManager.isMicrotuned(), juce::dontSendNotification);
+    juce::PopupMenu menu;
+    menu.addItem("Load Scala File...", [this] { loadScala(); });
+    menu.addItem("Equal Temperament", true, !tuningManager.isMicrotuned(), [this] {
+        tuningManager.resetTuning();
+        tuningButton.setToggleState(false, juce::dontSendNotification);
+    });
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&tuningButton));
+}
+
+void HeaderComp::loadScala()
+{
+    // A scale (.scl), and optionally the keyboard mapping (.kbm) to go with it, selected together
+    fileChooser = std::make_unique<juce::FileChooser>("Choose a Scala scale and, optionally, a keyboard mapping",
+                        juce::File::getSpecialLocation(juce::File::userDocumentsDirectory), "*.scl;*.kbm");
+    const auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles
+                     | juce::FileBrowserComponent::canSelectMultipleItems;
+    fileChooser->launchAsync(flags, [this](const juce::FileChooser& chooser) {
+        juce::File scale, mapping;
+        for (const auto& file : chooser.getResults())
+        {
+            if (file.hasFileExtension("kbm"))
+                mapping = file;
+            else
+                scale = file;
+        }
+        if (scale == juce::File())
+        {
+            if (mapping != juce::File())
+                juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Tuning",
+                                                       "A keyboard mapping needs a scale (.scl) chosen with it.");
+            return;
+        }
+        const auto result = tuningManager.loadScala(scale, mapping);
+        if (result.failed())
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Tuning",
+                                                   result.getErrorMessage());
+        tuningButton.setToggleState(tuningManager.isMicrotuned(), juce::dontSendNotification);
+    });
+}
@@ -12,13 +12,15 @@
 
 #include <JuceHeader.h>
 #include "PresetPanel.h"
+#include "../TuningManager.h"
+#include "../DSP/Modulation.h"
 
 //==============================================================================
 
 class HeaderComp  : public juce::Component
 {
 public:
-    HeaderComp(PresetManager&);
+    HeaderComp(PresetManager&, TuningManager&);
     ~HeaderComp() override;
 
     void paint (juce::Graphics&) override;
@@ -26,11 +28,20 @@ public:
     
     // Callback for FX button
     std::function<void()> onFXButtonClicked;
+    // Meter under the buttons: the cost of each modulation source's routes, blank while none are active
+    void showModulationLoad(const ModulationLoad& load);
 
 private:
     PresetPanel presetPanel;
+    TuningManager& tuningManager;
+    juce::TextButton tuningButton;
     juce::TextButton fxButton;
+    juce::Label modulationMeter;
+    std::unique_ptr<juce::FileChooser> fileChooser;
     
     void showFXPopup();
+    // Menu of the tuning button: load a Scala scale, optionally with a keyboard mapping, or go back to 12-TET
+    void showTuningMenu();
+    void loadScala();
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HeaderComp)
 };
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    ParameterSnapshot.cpp
+
+  ==============================================================================
+*/
+
+#include "ParameterSnapshot.h"
+#include <limits>
+
+ParameterSnapshot::ParameterSnapshot(juce::AudioProcessorValueTreeState& apvts)
+{
+    // Same order as OperatorParam, GlobalParam and ModSlotParam
+    static const char* const operatorPrefixes[numOperatorParams] = {
+        "FINE_", "COARSE_", "LEVEL_", "RATIO_", "MOD_INDEX_", "WAVE_", "ATTACK_", "DECAY_", "SUSTAIN_", "RELEASE_"
+    };
+    static const char* const globalIDs[numGlobalParams] = {
+        "CUTOFF", "RESONANCE", "ALG_INDEX", "RENDER_QUALITY", "ENV_CURVE", "POLYPHONY", "VOICE_STEALING", "RENDER_THREADS", "OVERSAMPLING",
+        "FILTER_MODE", "FILTER_KEY_TRACK", "FILTER_ENV_AMOUNT", "FILTER_ATTACK", "FILTER_DECAY", "FILTER_SUSTAIN", "FILTER_RELEASE",
+        "LFO1_RATE", "LFO1_SHAPE", "LFO2_RATE", "LFO2_SHAPE", "MOD_CONTROL_RATE", "ALG_MODE", "ALG_SWITCH", "CYCLE_CACHE",
+        "UNISON_VOICES", "UNISON_DETUNE", "UNISON_SPREAD"
+    };
+    static const char* const modSlotSuffixes[numModSlotParams] = { "_SOURCE", "_TARGET", "_AMOUNT" };
+
+    for (int op = 0; op < numOperators; ++op)
+    {
+        for (int param = 0; param < numOperatorParams; ++param)
+        {
+            const auto index = size_t(op * numOperatorParams + param);
+            sources[index] = apvts.getRawParameterValue(juce::String(operatorPrefixes[param]) + juce::String(op + 1));
+            changeFlags[index] = param < attack ? oscillatorChanged(op) : envelopeChanged(op);
+        }
+    }
+    for (int param = 0; param < numGlobalParams; ++param)
+    {
+        const auto index = size_t(numOperators * numOperatorParams + param);
+        sources[index] = apvts.getRawParameterValue(globalIDs[param]);
+        changeFlags[index] = globalChanged(static_cast<GlobalParam>(param));
+    }
+    for (int slot = 0; slot < numModSlots; ++slot)
+    {
+        for (int param = 0; param < numModSlotParams; ++param)
+        {
+            const auto index = size_t(firstModSlotValue + slot * numModSlotParams + param);
+            sources[index] = apvts.getRawParameterValue("MOD_" + juce::String(slot + 1) + modSlotSuffixes[param]);
+            changeFlags[index] = modRoutesChanged();
+        }
+    }
+    for (int op = 0; op < numOperators; ++op)
+    {
+        for (int modulator = 0; modulator < numOperators; ++modulator)
+        {
+            const auto index = size_t(firstMatrixValue + op * numOperators + modulator);
+            sources[index] = apvts.getRawParameterValue("MATRIX_" + juce::String(op + 1) + "_" + juce::String(modulator + 1));
+            changeFlags[index] = matrixChanged();
+        }
+        const auto index = size_t(firstMatrixValue + numOperators * numOperators + op);
+        sources[index] = apvts.getRawParameterValue("MATRIX_OUT_" + juce::String(op + 1));
+        changeFlags[index] = matrixChanged();
+    }
+
+    for (auto* source : sources)
+        jassert(source != nullptr); // parameter missing from the layout
+    markAllChanged();
+}
+
+uint64_t ParameterSnapshot::update() noexcept
+{
+    uint64_t changes = 0;
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        const float value = sources[i]->load(std::memory_order_relaxed);
+        if (value != values[i])
+        {
+            values[i] = value;
+            changes |= changeFlags[i];
+        }
+    }
+    return changes;
+}
+
+void ParameterSnapshot::markAllChanged() noexcept
+{
+    // NaN never compares equal, so every value reads as changed
+    values.fill(std::numeric_limits<float>::quiet_NaN());
+}
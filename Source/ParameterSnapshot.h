@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    ParameterSnapshot.h
+
+    Typed view of the synth parameters for the audio thread. The parameter
+    atomics are looked up by ID once, at construction; each block update()
+    copies their values and reports which groups moved, so the processor
+    only forwards what actually changed.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+class ParameterSnapshot
+{
+public:
+    static constexpr int numOperators = 6;
+
+    /// Per-operator parameters ("FINE_1" ... "RELEASE_6")
+    enum OperatorParam
+    {
+        fine, coarse, level, ratio, modIndex, waveform,   // oscillator group
+        attack, decay, sustain, release,        // envelope group
+        numOperatorParams
+    };
+
+    /// Synth-wide parameters, each its own group
+    enum GlobalParam
+    {
+        cutoff, resonance, algIndex, renderQuality, envCurve, polyphony, voiceStealing, renderThreads, oversampling,
+        filterMode, filterKeyTracking, filterEnvAmount, filterAttack, filterDecay, filterSustain, filterRelease,
+        lfo1Rate, lfo1Shape, lfo2Rate, lfo2Shape, modControlRate, algMode, algSwitch, cycleCache,
+        unisonVoices, unisonDetune, unisonSpread,
+        numGlobalParams
+    };
+
+    static constexpr int numModSlots = 8;
+
+    /// Per-slot modulation route parameters ("MOD_1_SOURCE" ... "MOD_8_AMOUNT"), all one group
+    enum ModSlotParam
+    {
+        modSource, modTarget, modAmount,
+        numModSlotParams
+    };
+
+    /// Change flags returned by update()
+    static constexpr uint64_t oscillatorChanged(int op) { return uint64_t(1) << op; }
+    static constexpr uint64_t envelopeChanged(int op) { return uint64_t(1) << (numOperators + op); }
+    static constexpr uint64_t globalChanged(GlobalParam param) { return uint64_t(1) << (2 * numOperators + param); }
+    static constexpr uint64_t modRoutesChanged() { return uint64_t(1) << (2 * numOperators + numGlobalParams); }
+    /// Any depth or output level of the matrix algorithm ("MATRIX_1_1" ... "MATRIX_OUT_6")
+    static constexpr uint64_t matrixChanged() { return uint64_t(1) << (2 * numOperators + numGlobalParams + 1); }
+
+    /// Resolves every parameter of the layout. Call after the APVTS has been constructed.
+    explicit ParameterSnapshot(juce::AudioProcessorValueTreeState& apvts);
+
+    /// Reads every parameter and returns the flags of the groups whose values changed since the last call.
+    /// No strings, no lookups and no allocation: one relaxed atomic load and compare per parameter.
+    uint64_t update() noexcept;
+
+    /// Makes the next update() report every group as changed, e.g. after the voice pool was rebuilt.
+    void markAllChanged() noexcept;
+
+    float get(int op, OperatorParam param) const noexcept { return values[size_t(op * numOperatorParams + param)]; }
+    float get(GlobalParam param) const noexcept { return values[size_t(numOperators * numOperatorParams + param)]; }
+    float get(int slot, ModSlotParam param) const noexcept { return values[size_t(firstModSlotValue + slot * numModSlotParams + param)]; }
+    /// Depth at which operator modulator modulates operator modulated (zero-based)
+    float getMatrixDepth(int modulated, int modulator) const noexcept { return values[size_t(firstMatrixValue + modulated * numOperators + modulator)]; }
+    float getMatrixOutput(int op) const noexcept { return values[size_t(firstMatrixValue + numOperators * numOperators + op)]; }
+
+private:
+    static constexpr int firstModSlotValue = numOperators * numOperatorParams + numGlobalParams;
+    static constexpr int firstMatrixValue = firstModSlotValue + numModSlots * numModSlotParams;
+    static constexpr int numValues = firstMatrixValue + numOperators * numOperators + numOperators;
+    static_assert(2 * numOperators + numGlobalParams + 2 <= 64, "the change flags no longer fit");
+
+    std::array<std::atomic<float>*, numValues> sources{};
+    std::array<uint64_t, numValues> changeFlags{}; // group flag of each value
+    std::array<float, numValues> values{};
+};
@@ -12,7 +12,7 @@
 //==============================================================================
 OutsetAudioProcessorEditor::OutsetAudioProcessorEditor (OutsetAudioProcessor& p, juce::MidiKeyboardState& ks )
 : AudioProcessorEditor (&p), audioProcessor (p), filter_comp(audioProcessor.apvts, audioProcessor.getRTA()), keyboard_comp(ks), alg_comp(audioProcessor.apvts), osc_env_tab(audioProcessor.apvts),
-    header_comp(audioProcessor.getPresetManager()), fx_comp(audioProcessor.apvts)
+    header_comp(audioProcessor.getPresetManager(), audioProcessor.getTuningManager()), fx_comp(audioProcessor.apvts)
 {
     double ratio = 4.0 / 3.0;
     setResizeLimits(400, 400 / ratio, 1200, 1200 / ratio);
@@ -38,7 +38,7 @@ OutsetAudioProcessorEditor::OutsetAudioProcessorEditor (OutsetAudioProcessor& p,
     };
     
 	setResizable(true, true);
-    
+    startTimerHz(2); // modulation meter
 }
 
 OutsetAudioProcessorEditor::~OutsetAudioProcessorEditor()
@@ -51,6 +51,7 @@ private:
     void timerCallback() override
     {
         //scopeComponent.setAudioData(audioProcessor.getAudioBuffer());
+        header_comp.showModulationLoad(audioProcessor.takeModulationLoad());
     }
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OutsetAudioProcessorEditor)
 };
@@ -22,7 +22,8 @@ OutsetAudioProcessor::OutsetAudioProcessor()
                        )
 #endif
 {
-    filter = std::make_unique<Filters>();
+    filter = std::make_unique<Filters<float>>();
+    doubleFilter = std::make_unique<Filters<double>>();
     scope = std::make_unique<Scope>();
     
     // Create FX engine
@@ -31,10 +32,14 @@ OutsetAudioProcessor::OutsetAudioProcessor()
     apvts.state.setProperty(PresetManager::presetNameProperty, "", nullptr);
     apvts.state.setProperty("version", ProjectInfo::versionString, nullptr);
     presetManager = std::make_unique<PresetManager>(apvts);
+    tuningManager = std::make_unique<TuningManager>(apvts);
+    reportedTailSeconds = getTailLengthSeconds();
+    startTimerHz(2);
 }
 
 OutsetAudioProcessor::~OutsetAudioProcessor()
 {
+    stopTimer();
 }
 
 //==============================================================================
@@ -70,9 +75,32 @@ bool OutsetAudioProcessor::isMidiEffect() const
    #endif
 }
 
+bool OutsetAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
 double OutsetAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // After the last note-off: the longest release, the operators' or the filter envelope's, which can
+    // still be opening the filter on a ringing note, then the effect tails in series
+    float release = apvts.getRawParameterValue("FILTER_RELEASE")->load();
+    for (int i = 1; i <= 6; ++i)
+        release = juce::jmax(release, apvts.getRawParameterValue("RELEASE_" + juce::String(i))->load());
+    const double effectsTail = fxEngine != nullptr ? fxEngine->getTailLengthSeconds(silenceThreshold) : 0.0;
+    return release + effectsTail;
+}
+
+void OutsetAudioProcessor::timerCallback()
+{
+    // Hosts read the tail when told the processor changed; there is no flag for the tail alone. Only a coarse move
+    // is reported, so a knob being dragged doesn't notify on every tick, and only as a non-parameter state change:
+    // the default details also flag latency, which VST3 hosts answer by restarting processing
+    const double tail = getTailLengthSeconds();
+    if (std::abs(tail - reportedTailSeconds) < juce::jmax(tailReportTolerance, reportedTailSeconds * 0.25))
+        return;
+    reportedTailSeconds = tail;
+    updateHostDisplay(juce::AudioProcessorListener::ChangeDetails{}.withNonParameterStateChanged(true));
 }
 
 int OutsetAudioProcessor::getNumPrograms()
@@ -108,17 +136,42 @@ void OutsetAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock
     spec.sampleRate = sampleRate;
     spec.maximumBlockSize = samplesPerBlock;
     spec.numChannels = 2;
+    // The voices and the filter form a mono core, unless unison spreads the voices in stereo;
+    // the FX chain goes stereo where it has to
     filter->prepare(spec);
+    doubleFilter->prepare(spec);
+    coreBuffer.setSize(2, juce::jmax(1, samplesPerBlock));
+    analysisBuffer.setSize(2, juce::jmax(1, samplesPerBlock));
+    // Oversampling first, so the voices are prepared at their final rate and the host sees the latency now
+    setOversampling(apvts.getRawParameterValue("OVERSAMPLING")->load());
+    // Likewise the thread count, so the pool spawns just the render threads asked for
+    setRenderThreads(apvts.getRawParameterValue("RENDER_THREADS")->load());
     synth.allocateResources(sampleRate, samplesPerBlock);
+    parameters.markAllChanged(); // push every parameter into the (possibly new) voice pool
     rta.setSampleRate(sampleRate);
     
     // Prepare FX engine
     if (fxEngine)
-        fxEngine->prepare(spec);
+        fxEngine->prepare(spec, isUsingDoublePrecision());
     
     reset();
 }
 
+void OutsetAudioProcessor::setOversampling(float choice)
+{
+    // Off, 2x, 4x, Auto: Auto picks 1x to 4x per voice and always reports the 4x latency
+    static constexpr int oversamplingFactors[] = { 1, 2, 4, 4 };
+    const int mode = juce::jlimit(0, 3, static_cast<int>(choice));
+    synth.setOversampling(oversamplingFactors[mode], mode == 3);
+    setLatencySamples(synth.getLatencySamples());
+}
+
+void OutsetAudioProcessor::setRenderThreads(float choice)
+{
+    static constexpr int threadModes[] = { 1, 2, 4, 8 };
+    synth.setNumRenderThreads(threadModes[juce::jlimit(0, 3, static_cast<int>(choice))]);
+}
+
 void OutsetAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
@@ -134,6 +187,10 @@ void OutsetAudioProcessor::reset()
     // Reset FX engine
     if (fxEngine)
         fxEngine->reset();
+
+    // Nothing is sounding and every state is clear, so there is nothing to render until a note starts
+    sleeping = true;
+    silentSamples = 0;
 }
 
 
@@ -164,6 +221,17 @@ bool OutsetAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
 #endif
 
 void OutsetAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, midiMessages);
+}
+
+void OutsetAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, midiMessages);
+}
+
+template <typename SampleType>
+void OutsetAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -182,50 +250,179 @@ void OutsetAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce:
     
     //our code (non-template stuff) starts here
   
-    double cutoff = apvts.getRawParameterValue("CUTOFF")->load();
-	double q = apvts.getRawParameterValue("RESONANCE")->load();
-    int algIndex = apvts.getRawParameterValue("ALG_INDEX")->load();
-
-
+    // Only parameters that moved since the last block are forwarded
+    const auto changes = parameters.update();
+    using P = ParameterSnapshot;
 
-    //DBG(cutoff);
-    //DBG(attack3);
-    //DBG(fine1);
-    
-	filter->setCutoffFrequency(cutoff);
-	filter->setResonance(q);
-    synth.updateAlgorithm(algIndex);
+    // Cutoff and resonance drive the global filter and the voice filters alike
+    if (changes & P::globalChanged(P::cutoff))
+    {
+        filter->setCutoffFrequency(parameters.get(P::cutoff));
+        doubleFilter->setCutoffFrequency(parameters.get(P::cutoff));
+        synth.setFilterCutoff(parameters.get(P::cutoff));
+    }
+    if (changes & P::globalChanged(P::resonance))
+    {
+        filter->setResonance(parameters.get(P::resonance));
+        doubleFilter->setResonance(parameters.get(P::resonance));
+        synth.setFilterResonance(parameters.get(P::resonance));
+    }
+    if (changes & P::globalChanged(P::cycleCache))
+        synth.setCycleCaching(parameters.get(P::cycleCache) > 0.5f);
+    if (changes & (P::globalChanged(P::unisonVoices) | P::globalChanged(P::unisonDetune) | P::globalChanged(P::unisonSpread)))
+        synth.setUnison(static_cast<int>(parameters.get(P::unisonVoices)), parameters.get(P::unisonDetune),
+                        parameters.get(P::unisonSpread));
+    if (changes & P::globalChanged(P::filterMode))
+    {
+        voiceFiltering = parameters.get(P::filterMode) > 0.5f;
+        synth.setVoiceFiltering(voiceFiltering);
+        filter->reset();
+        doubleFilter->reset();
+    }
+    if (changes & P::globalChanged(P::filterKeyTracking))
+        synth.setFilterKeyTracking(parameters.get(P::filterKeyTracking));
+    if (changes & P::globalChanged(P::filterEnvAmount))
+        synth.setFilterEnvelopeAmount(parameters.get(P::filterEnvAmount));
+    if (changes & (P::globalChanged(P::filterAttack) | P::globalChanged(P::filterDecay)
+                   | P::globalChanged(P::filterSustain) | P::globalChanged(P::filterRelease)))
+        synth.updateFilterADSR(parameters.get(P::filterAttack),
+                               parameters.get(P::filterDecay),
+                               parameters.get(P::filterSustain),
+                               parameters.get(P::filterRelease));
+    if (changes & P::globalChanged(P::algSwitch))
+        synth.setAlgorithmSwitchMode(static_cast<AlgSwitchMode>(juce::jlimit(0, 2, static_cast<int>(parameters.get(P::algSwitch)))));
+    if (changes & P::globalChanged(P::algIndex))
+        synth.updateAlgorithm(static_cast<int>(parameters.get(P::algIndex)));
+    if (changes & P::matrixChanged())
+    {
+        MatrixAlgorithm matrix;
+        for (int op = 0; op < P::numOperators; ++op)
+        {
+            for (int modulator = 0; modulator < P::numOperators; ++modulator)
+                matrix.setDepth(op, modulator, parameters.getMatrixDepth(op, modulator));
+            matrix.setOutputLevel(op, parameters.getMatrixOutput(op));
+        }
+        synth.setMatrixAlgorithm(matrix);
+    }
+    if (changes & P::globalChanged(P::algMode))
+        synth.setMatrixMode(parameters.get(P::algMode) > 0.5f);
+    if (changes & P::globalChanged(P::renderQuality))
+    {
+        // Draft / High / Reference, see FastSine.h for the error of each engine
+        static constexpr SineMode qualityModes[] = { SineMode::Table, SineMode::Polynomial, SineMode::Exact };
+        synth.setSineMode(qualityModes[juce::jlimit(0, 2, static_cast<int>(parameters.get(P::renderQuality)))]);
+    }
+    if (changes & P::globalChanged(P::envCurve))
+        synth.setEnvelopeCurve(parameters.get(P::envCurve) > 0.5f ? Envelope::Curve::Exponential : Envelope::Curve::Linear);
+    if (changes & P::globalChanged(P::polyphony))
+    {
+        static constexpr int polyphonyModes[] = { 8, 32, 64, 128 };
+        synth.setPolyphony(polyphonyModes[juce::jlimit(0, 3, static_cast<int>(parameters.get(P::polyphony)))]);
+    }
+    if (changes & P::globalChanged(P::voiceStealing))
+        synth.setStealPolicy(static_cast<StealPolicy>(juce::jlimit(0, 3, static_cast<int>(parameters.get(P::voiceStealing)))));
+    if (changes & P::globalChanged(P::renderThreads))
+        setRenderThreads(parameters.get(P::renderThreads));
+    if (changes & P::globalChanged(P::oversampling))
+        setOversampling(parameters.get(P::oversampling));
+    if (changes & (P::globalChanged(P::lfo1Rate) | P::globalChanged(P::lfo1Shape)))
+        synth.setLfo(0, static_cast<LfoShape>(juce::jlimit(0, 4, static_cast<int>(parameters.get(P::lfo1Shape)))),
+                     parameters.get(P::lfo1Rate));
+    if (changes & (P::globalChanged(P::lfo2Rate) | P::globalChanged(P::lfo2Shape)))
+        synth.setLfo(1, static_cast<LfoShape>(juce::jlimit(0, 4, static_cast<int>(parameters.get(P::lfo2Shape)))),
+                     parameters.get(P::lfo2Rate));
+    if (changes & P::globalChanged(P::modControlRate))
+    {
+        static constexpr int controlIntervals[] = { 16, 32, 64 };
+        synth.setModulationControlInterval(controlIntervals[juce::jlimit(0, 2, static_cast<int>(parameters.get(P::modControlRate)))]);
+    }
+    if (changes & P::modRoutesChanged())
+    {
+        static_assert(P::numModSlots == ModMatrix::numSlots, "one route slot per MOD_n parameter set");
+        for (int slot = 0; slot < P::numModSlots; ++slot)
+            synth.setModulationRoute(slot,
+                                     static_cast<ModSource>(juce::jlimit(0, 3, static_cast<int>(parameters.get(slot, P::modSource)))),
+                                     static_cast<int>(parameters.get(slot, P::modTarget)),
+                                     parameters.get(slot, P::modAmount));
+    }
 	for (int i = 0; i < 6; i++) {
-
-        synth.updateOsc(apvts.getRawParameterValue("FINE_" + juce::String(i + 1))->load(),
-                        apvts.getRawParameterValue("COARSE_" + juce::String(i + 1))->load(),
-                        apvts.getRawParameterValue("LEVEL_" + juce::String(i + 1))->load(),
-                        apvts.getRawParameterValue("RATIO_" + juce::String(i + 1))->load(),
-                        apvts.getRawParameterValue("MOD_INDEX_" + juce::String(i + 1))->load(),
-                        i);
-        synth.updateADSR(apvts.getRawParameterValue("ATTACK_" + juce::String(i + 1))->load(), 
-                         apvts.getRawParameterValue("DECAY_" + juce::String(i + 1))->load(),
-                         apvts.getRawParameterValue("SUSTAIN_" + juce::String(i + 1))->load(),
-                         apvts.getRawParameterValue("RELEASE_" + juce::String(i + 1))->load(),
-                         i);
+        if (changes & P::oscillatorChanged(i))
+        {
+            synth.updateOsc(parameters.get(i, P::fine),
+                            parameters.get(i, P::coarse),
+                            parameters.get(i, P::level),
+                            parameters.get(i, P::ratio),
+                            parameters.get(i, P::modIndex),
+                            i);
+            synth.setWaveform(static_cast<Waveform>(juce::jlimit(0, 1, static_cast<int>(parameters.get(i, P::waveform)))), i);
+        }
+        if (changes & P::envelopeChanged(i))
+            synth.updateADSR(parameters.get(i, P::attack),
+                             parameters.get(i, P::decay),
+                             parameters.get(i, P::sustain),
+                             parameters.get(i, P::release),
+                             i);
 	}
+    // A tuning loaded or recalled on the message thread applies to the notes started from this block on
+    tuningManager->applyPending([this](const TuningTable& tuning) { synth.setTuning(tuning); });
     keyboardState.processNextMidiBuffer(midiMessages, 0, buffer.getNumSamples(), true);
+
+    if (sleeping)
+    {
+        // Only a note-on can make a sound; anything else is dropped along with the block
+        bool noteStarts = false;
+        for (const auto metadata : midiMessages)
+            noteStarts = noteStarts || metadata.getMessage().isNoteOn();
+        if (!noteStarts)
+        {
+            buffer.clear();
+            midiMessages.clear();
+            return;
+        }
+        // Ramps that would have run while asleep end on their targets instead of gliding under the note
+        synth.snapParameterRamps();
+        filter->snapToTargets();
+        doubleFilter->snapToTargets();
+        sleeping = false;
+    }
+
+    // Fixed for the block: parameters only change above, before anything is rendered
+    const bool stereo = isStereoCore(buffer);
     splitBufferByEvents(buffer, midiMessages);
-    filter->processBlock(buffer);
+    if (!voiceFiltering)
+    {
+        juce::dsp::AudioBlock<SampleType> block(buffer);
+        getFilter<SampleType>().processBlock(stereo ? block.getSubsetChannelBlock(0, 2) : block.getSingleChannelBlock(0));
+    }
     
-    // Process through FX chain
+    // Process through FX chain, which expands a mono core to every output channel
     if (fxEngine)
-        fxEngine->processBlock(buffer);
+        fxEngine->processBlock(buffer, !stereo);
+    else
+        for (int channel = stereo ? 2 : 1; channel < buffer.getNumChannels(); ++channel)
+            buffer.copyFrom(channel, 0, buffer, 0, 0, buffer.getNumSamples());
     
+    // The analysers take float; in double precision they get a copy
+    const juce::AudioBuffer<float>* analysed = nullptr;
+    if constexpr (std::is_same_v<SampleType, float>)
+        analysed = &buffer;
+    else
+    {
+        analysisBuffer.makeCopyOf(buffer, true);
+        analysed = &analysisBuffer;
+    }
+
     // Feed RTA at end of processing (post-FX output)
     {
         const float* chans[2] = { nullptr, nullptr };
-        for (int ch = 0; ch < juce::jmin(2, buffer.getNumChannels()); ++ch)
-            chans[ch] = buffer.getReadPointer(ch);
-        rta.pushAudioBuffer(chans, buffer.getNumChannels(), buffer.getNumSamples());
+        for (int ch = 0; ch < juce::jmin(2, analysed->getNumChannels()); ++ch)
+            chans[ch] = analysed->getReadPointer(ch);
+        rta.pushAudioBuffer(chans, analysed->getNumChannels(), analysed->getNumSamples());
     }
     
-	scope->setAudioData(buffer);
+	scope->setAudioData(*analysed);
+
+    updateSleep(buffer);
     
     
     //uncomment these to check that parameters and sliders are linked
@@ -233,7 +430,36 @@ void OutsetAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce:
 
 }
 
-void OutsetAudioProcessor::splitBufferByEvents(juce::AudioBuffer<float>& buffer,
+template <typename SampleType>
+void OutsetAudioProcessor::updateSleep(const juce::AudioBuffer<SampleType>& buffer)
+{
+    const int numSamples = buffer.getNumSamples();
+    if (!synth.isIdle() || buffer.getMagnitude(0, numSamples) >= silenceThreshold)
+    {
+        silentSamples = 0;
+        return;
+    }
+    silentSamples += numSamples;
+
+    // A quiet stretch shorter than the chain's delays may be the gap before an echo or a reverb return;
+    // the decimation filters may still be emptying too
+    const double delaySeconds = fxEngine != nullptr ? fxEngine->getLongestInternalDelaySeconds() : 0.0;
+    const int holdSamples = static_cast<int>(std::ceil(delaySeconds * getSampleRate())) + synth.getLatencySamples();
+    if (silentSamples <= holdSamples)
+        return;
+
+    // What is left is below the threshold; clearing it means the chain wakes from the state it was reset to,
+    // and a delay or reverb turned down to a mix of zero does not bring back old signal later
+    filter->reset();
+    doubleFilter->reset();
+    if (fxEngine)
+        fxEngine->reset();
+    sleeping = true;
+    silentSamples = 0;
+}
+
+template <typename SampleType>
+void OutsetAudioProcessor::splitBufferByEvents(juce::AudioBuffer<SampleType>& buffer,
 juce::MidiBuffer& midiMessages)
 {
     int bufferOffset = 0;
@@ -274,15 +500,36 @@ void OutsetAudioProcessor::handleMIDI(uint8_t data0, uint8_t data1, uint8_t data
     
 }
 
-void OutsetAudioProcessor::render(juce::AudioBuffer<float>& buffer, int sampleCount, int bufferOffset) 
+template <typename SampleType>
+void OutsetAudioProcessor::render(juce::AudioBuffer<SampleType>& buffer, int sampleCount, int bufferOffset)
 {
-    float* outputBuffers[2] = { nullptr, nullptr }; 
-    outputBuffers[0] = buffer.getWritePointer(0) + bufferOffset;
-    if (getTotalNumOutputChannels() > 1) { //conditional checks for if audio is stereo.
-        outputBuffers[1] = buffer.getWritePointer(1) + bufferOffset;
+    // Mono core: the synth fills channel 0 only, and processBlock expands it after the filter and mono FX.
+    // A unison stack spread in stereo fills channels 0 and 1.
+    const int numCoreChannels = isStereoCore(buffer) ? 2 : 1;
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        float* outputBuffers[2] = { buffer.getWritePointer(0) + bufferOffset,
+                                    numCoreChannels == 2 ? buffer.getWritePointer(1) + bufferOffset : nullptr };
+        synth.render(outputBuffers, sampleCount);
+    }
+    else
+    {
+        // The voices are float: their sum is widened once, here, and everything after it runs in double
+        for (int start = 0; start < sampleCount; start += coreBuffer.getNumSamples())
+        {
+            const int numSamples = juce::jmin(coreBuffer.getNumSamples(), sampleCount - start);
+            float* outputBuffers[2] = { coreBuffer.getWritePointer(0),
+                                        numCoreChannels == 2 ? coreBuffer.getWritePointer(1) : nullptr };
+            synth.render(outputBuffers, numSamples);
+            for (int channel = 0; channel < numCoreChannels; ++channel)
+            {
+                double* output = buffer.getWritePointer(channel) + bufferOffset;
+                const float* core = coreBuffer.getReadPointer(channel);
+                for (int i = 0; i < numSamples; ++i)
+                    output[start + i] = static_cast<double>(core[i]);
+            }
+        }
     }
-    
-    synth.render(outputBuffers, sampleCount);
 }
 
 //==============================================================================
@@ -403,6 +650,15 @@ juce::AudioProcessorValueTreeState::ParameterLayout OutsetAudioProcessor::create
             modRange,
             1.0f));
     }
+    // Waveform Parameters (6)
+    for (int i = 1; i <= 6; ++i)
+    {
+        layout.add(std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID("WAVE_" + juce::String(i), 1),
+            "Wave" + juce::String(i),
+            juce::StringArray{"Sine", "Noise"},  // order of Waveform
+            0));
+    }
     // Cutoff Parameter (1)
     juce::NormalisableRange<float> cutoffRange(20.0f, 20000.0f, 1.0f);
     cutoffRange.setSkewForCentre(1000.0f);
@@ -476,6 +732,180 @@ juce::AudioProcessorValueTreeState::ParameterLayout OutsetAudioProcessor::create
         31,                                // Maximum value
         0));                               // Default value
 
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("ALG_MODE", 1),
+        "Alg Mode",
+        juce::StringArray{"Fixed", "Matrix"},
+        0)  // Matrix: the MATRIX_ depths and output levels below replace ALG_INDEX
+    );
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("ALG_SWITCH", 1),
+        "Alg Switch",
+        juce::StringArray{"Instant", "New Notes", "Crossfade"},  // order of AlgSwitchMode
+        2)  // sounding notes fade to a new algorithm over 5 ms, so automating ALG_INDEX does not click
+    );
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("RENDER_QUALITY", 1),
+        "Render Quality",
+        juce::StringArray{"Draft", "High", "Reference"},
+        1)  // Default: High (polynomial sine)
+    );
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("ENV_CURVE", 1),
+        "Envelope Curve",
+        juce::StringArray{"Linear", "Exponential"},
+        0)
+    );
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("POLYPHONY", 1),
+        "Polyphony",
+        juce::StringArray{"8", "32", "64", "128"},
+        0)  // voices are preallocated for the largest setting, so switching never allocates
+    );
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("VOICE_STEALING", 1),
+        "Voice Stealing",
+        juce::StringArray{"Oldest", "Quietest", "Release First", "Same Note"},  // order of StealPolicy
+        2)
+    );
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("RENDER_THREADS", 1),
+        "Render Threads",
+        juce::StringArray{"1", "2", "4", "8"},
+        0)  // 1: render every voice on the audio thread
+    );
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("OVERSAMPLING", 1),
+        "Oversampling",
+        juce::StringArray{"Off", "2x", "4x", "Auto"},
+        0)  // voices only; filter and FX stay at the host rate. 2x adds 16 samples of latency, 4x and Auto 19
+    );
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("CYCLE_CACHE", 1),
+        "Cycle Cache",
+        juce::StringArray{"Off", "On"},
+        1)  // held voices with integer ratios play one cached cycle instead of evaluating their operators
+    );
+
+    // Unison: each note plays up to 8 detuned copies of the voice, spread across the stereo field
+    layout.add(std::make_unique<juce::AudioParameterInt>(
+        juce::ParameterID("UNISON_VOICES", 1), "Unison Voices", 1, 8, 1));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID("UNISON_DETUNE", 1),
+        "Unison Detune",
+        juce::NormalisableRange<float>(0.0f, 100.0f, 0.1f),  // cents, of the outermost copies
+        10.0f));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID("UNISON_SPREAD", 1),
+        "Unison Spread",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f),  // 0 keeps the copies centred and the core mono
+        0.5f));
+
+    // Per-voice filter: CUTOFF and RESONANCE, moved by key tracking and a filter envelope
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("FILTER_MODE", 1),
+        "Filter Mode",
+        juce::StringArray{"Global", "Per Voice"},
+        0)  // Global: one filter after the voice sum, no key tracking or envelope
+    );
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID("FILTER_KEY_TRACK", 1),
+        "Filter Key Track",
+        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f),
+        0.0f));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID("FILTER_ENV_AMOUNT", 1),
+        "Filter Env Amount",
+        juce::NormalisableRange<float>(-8.0f, 8.0f, 0.01f),  // octaves
+        0.0f));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID("FILTER_ATTACK", 1), "Filter Attack", attackRange, 0.1f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID("FILTER_DECAY", 1), "Filter Decay", decayRange, 0.1f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID("FILTER_SUSTAIN", 1), "Filter Sustain", sustainRange, 0.8f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID("FILTER_RELEASE", 1), "Filter Release", releaseRange, 0.1f));
+
+    // LFOs and modulation routes (see DSP/Modulation.h). LFO 1 is shared by all voices, LFO 2 runs per voice
+    juce::NormalisableRange<float> lfoRateRange(0.01f, 30.0f, 0.01f);
+    lfoRateRange.setSkewForCentre(2.0f);
+    for (int i = 1; i <= 2; ++i)
+    {
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID("LFO" + juce::String(i) + "_RATE", 1),
+            "LFO " + juce::String(i) + " Rate",
+            lfoRateRange,
+            1.0f));
+        layout.add(std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID("LFO" + juce::String(i) + "_SHAPE", 1),
+            "LFO " + juce::String(i) + " Shape",
+            juce::StringArray{"Sine", "Triangle", "Saw", "Square", "Sample & Hold"},  // order of LfoShape
+            0));
+    }
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID("MOD_CONTROL_RATE", 1),
+        "Mod Control Rate",
+        juce::StringArray{"16 Samples", "32 Samples", "64 Samples"},
+        1)  // routes are evaluated this often and interpolated in between
+    );
+
+    juce::StringArray modTargets;  // order of ModTarget
+    for (int i = 1; i <= 6; ++i)
+        modTargets.addArray(juce::StringArray{ "Op " + juce::String(i) + " Level",
+                                               "Op " + juce::String(i) + " Ratio",
+                                               "Op " + juce::String(i) + " Mod Index" });
+    modTargets.add("Filter Cutoff");  // per-voice filter only, and not from Noise
+    for (int i = 1; i <= 8; ++i)
+    {
+        layout.add(std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID("MOD_" + juce::String(i) + "_SOURCE", 1),
+            "Mod " + juce::String(i) + " Source",
+            juce::StringArray{"Off", "LFO 1", "LFO 2", "Noise"},  // order of ModSource
+            0));
+        layout.add(std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID("MOD_" + juce::String(i) + "_TARGET", 1),
+            "Mod " + juce::String(i) + " Target",
+            modTargets,
+            0));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID("MOD_" + juce::String(i) + "_AMOUNT", 1),
+            "Mod " + juce::String(i) + " Amount",
+            juce::NormalisableRange<float>(-1.0f, 1.0f, 0.001f),
+            0.0f));
+    }
+
+    // Matrix algorithm (see MatrixAlgorithm in DSP/AlgSpace.h). MATRIX_i_j is the depth at which operator j
+    // modulates operator i, MATRIX_i_i being feedback; MATRIX_OUT_i is operator i's output level
+    for (int i = 1; i <= 6; ++i)
+    {
+        for (int j = 1; j <= 6; ++j)
+            layout.add(std::make_unique<juce::AudioParameterFloat>(
+                juce::ParameterID("MATRIX_" + juce::String(i) + "_" + juce::String(j), 1),
+                "Matrix " + juce::String(j) + " > " + juce::String(i),
+                juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f),
+                0.0f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID("MATRIX_OUT_" + juce::String(i), 1),
+            "Matrix Out " + juce::String(i),
+            juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f),
+            i == 1 ? 1.0f : 0.0f));  // a lone carrier, so switching to the matrix is never silent
+    }
+
     // ====== FX Parameters (from OutsetVerbEngine) ======
     
     // BitCrusher parameters
@@ -14,11 +14,13 @@
 #include "GUI/Scope.h"
 #include "GUI/rta.h"
 #include "PresetManager.h"
+#include "TuningManager.h"
+#include "ParameterSnapshot.h"
 #include "FX/OutsetVerbEngine.h"
 //==============================================================================
 /**
 */
-class OutsetAudioProcessor  : public juce::AudioProcessor
+class OutsetAudioProcessor  : public juce::AudioProcessor, private juce::Timer
 {
 public:
     //==============================================================================
@@ -35,6 +37,9 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    // The voices stay float; in double only the widened voice sum, filter, EQ, delay and bit crusher run in double
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -65,19 +70,62 @@ public:
   RTA& getRTA() { return rta; }
     
     PresetManager& getPresetManager() { return *presetManager; }
+    TuningManager& getTuningManager() { return *tuningManager; }
     
     // FX Engine access
     OutsetVerbEngine& getFXEngine() { return *fxEngine; }
+    // What the modulation routes cost since the last call, for the editor's meter
+    ModulationLoad takeModulationLoad() { return synth.takeModulationLoad(); }
 private:
     juce::MidiKeyboardState keyboardState;
-    void splitBufferByEvents(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages);
+    // Both processBlock overloads; SampleType is float or double
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
+    template <typename SampleType>
+    void splitBufferByEvents(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages);
     void handleMIDI(uint8_t data0, uint8_t data1, uint8_t data2);
-    void render(juce::AudioBuffer<float>& buffer, int sampleCount, int bufferOffset);
+    template <typename SampleType>
+    void render(juce::AudioBuffer<SampleType>& buffer, int sampleCount, int bufferOffset);
+    void setOversampling(float choice); // OVERSAMPLING choice index; also reports the latency to the host
+    void setRenderThreads(float choice); // RENDER_THREADS choice index
+    // Message thread: tells the host when getTailLengthSeconds has changed, e.g. after a release or effect edit
+    void timerCallback() override;
+    double reportedTailSeconds = 0.0;
+    static constexpr double tailReportTolerance = 0.5;  // seconds the tail must move before hosts are told
+    // The synth fills channels 0 and 1 while unison spreads the voices and the bus has room for both
+    template <typename SampleType>
+    bool isStereoCore(const juce::AudioBuffer<SampleType>& buffer) const
+    {
+        return synth.isStereo() && buffer.getNumChannels() > 1;
+    }
+    template <typename SampleType>
+    void updateSleep(const juce::AudioBuffer<SampleType>& buffer);
     juce::AudioBuffer<float> lastBuffer;
-	std::unique_ptr<Filters> filter;
+    // The global filter at each precision. Parameters go to both; only the host's precision runs.
+	std::unique_ptr<Filters<float>> filter;
+    std::unique_ptr<Filters<double>> doubleFilter;
+    template <typename SampleType>
+    Filters<SampleType>& getFilter()
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            return *filter;
+        else
+            return *doubleFilter;
+    }
+    // The voices are float. In double precision they render here, and the RTA and scope read a float copy.
+    juce::AudioBuffer<float> coreBuffer, analysisBuffer;
+    bool voiceFiltering = false; // FILTER_MODE "Per Voice": the synth filters each voice and filter is bypassed
+    // Asleep, processBlock outputs silence without running the synth, filter, FX, RTA or scope. It falls
+    // asleep once no voice sounds and the output has stayed below silenceThreshold for longer than any
+    // delay in the chain, and wakes on the next note-on.
+    static constexpr float silenceThreshold = 3.0e-5f; // about -90 dB; also where the reported tail ends
+    bool sleeping = false;
+    int silentSamples = 0; // consecutive output samples below silenceThreshold with no voice sounding
     Synth synth;
+    ParameterSnapshot parameters { apvts }; // audio-thread view of apvts, resolved once
     std::unique_ptr<Scope> scope;
     std::unique_ptr<PresetManager> presetManager;
+    std::unique_ptr<TuningManager> tuningManager;
   RTA rta; // real-time analyzer
     
     // FX processing engine
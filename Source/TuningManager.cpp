@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    TuningManager.cpp
+
+  ==============================================================================
+*/
+
+#include "TuningManager.h"
+
+const juce::String TuningManager::scaleProperty{"tuningScale"};
+const juce::String TuningManager::mappingProperty{"tuningMapping"};
+
+TuningManager::TuningManager(juce::AudioProcessorValueTreeState& apvts) :
+    apvtsRef(apvts)
+{
+    apvtsRef.state.addListener(this);
+    applyState();
+}
+
+juce::Result TuningManager::loadScala(const juce::File& scaleFile, const juce::File& mappingFile)
+{
+    if (!scaleFile.existsAsFile())
+        return juce::Result::fail("Scale file " + scaleFile.getFullPathName() + " does not exist");
+    if (mappingFile != juce::File() && !mappingFile.existsAsFile())
+        return juce::Result::fail("Keyboard mapping file " + mappingFile.getFullPathName() + " does not exist");
+
+    const auto scale = scaleFile.loadFileAsString();
+    const auto mapping = mappingFile != juce::File() ? mappingFile.loadFileAsString() : juce::String();
+    TuningTable table;
+    const auto result = table.loadScala(scale, mapping);
+    if (result.failed())
+        return result;
+
+    apvtsRef.state.setProperty(scaleProperty, scale, nullptr);
+    apvtsRef.state.setProperty(mappingProperty, mapping, nullptr);
+    publish(table);
+    return result;
+}
+
+void TuningManager::resetTuning()
+{
+    apvtsRef.state.removeProperty(scaleProperty, nullptr);
+    apvtsRef.state.removeProperty(mappingProperty, nullptr);
+    publish(TuningTable());
+}
+
+bool TuningManager::isMicrotuned() const
+{
+    return apvtsRef.state.getProperty(scaleProperty).toString().isNotEmpty();
+}
+
+void TuningManager::valueTreeRedirected(juce::ValueTree&)
+{
+    applyState();
+}
+
+void TuningManager::applyState()
+{
+    TuningTable table;
+    const auto scale = apvtsRef.state.getProperty(scaleProperty).toString();
+    if (scale.isNotEmpty())
+    {
+        const auto result = table.loadScala(scale, apvtsRef.state.getProperty(mappingProperty).toString());
+        if (result.failed())
+        {
+            DBG("could not restore tuning, using equal temperament: " + result.getErrorMessage());
+            table.setEqualTemperament();
+        }
+    }
+    publish(table);
+}
+
+void TuningManager::publish(const TuningTable& table)
+{
+    const juce::SpinLock::ScopedLockType lock(pendingLock);
+    pending = table;
+    changed.store(true, std::memory_order_release);
+}
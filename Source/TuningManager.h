@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    TuningManager.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DSP/Tuning.h"
+
+/*
+TuningManager keeps the synth's tuning. The Scala texts are stored as properties
+of the plugin state, so sessions and presets recall the tuning with the parameters.
+Loading happens on the message thread; the audio thread picks up the new table
+with applyPending.
+*/
+class TuningManager : juce::ValueTree::Listener
+{
+public:
+    static const juce::String scaleProperty;
+    static const juce::String mappingProperty;
+
+    TuningManager(juce::AudioProcessorValueTreeState&);
+
+    /// Loads a Scala scale and optional keyboard mapping. On an error the tuning stays as it was.
+    juce::Result loadScala(const juce::File& scaleFile, const juce::File& mappingFile = {});
+    /// Back to 12-tone equal temperament
+    void resetTuning();
+    bool isMicrotuned() const;
+
+    /*
+    applyPending hands a table published since the last call to apply, on the audio thread.
+    It never waits: if the message thread is publishing, the table comes with the next block.
+    */
+    template <typename Function>
+    bool applyPending(Function&& apply)
+    {
+        if (!changed.load(std::memory_order_acquire))
+            return false;
+        const juce::SpinLock::ScopedTryLockType lock(pendingLock);
+        if (!lock.isLocked())
+            return false;
+        changed.store(false, std::memory_order_relaxed);
+        apply(static_cast<const TuningTable&>(pending));
+        return true;
+    }
+
+private:
+    void valueTreeRedirected(juce::ValueTree& treeWhichHasBeenChanged) override;
+    // Rebuilds the table from the state's properties
+    void applyState();
+    void publish(const TuningTable& table);
+
+    juce::AudioProcessorValueTreeState& apvtsRef;
+    juce::SpinLock pendingLock;
+    TuningTable pending;
+    std::atomic<bool> changed { false };
+};